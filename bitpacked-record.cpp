@@ -0,0 +1,219 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compile the code using:
+ * clang++ -std=c++17 -O3 ./bitpacked-record.cpp
+ * g++ -std=c++17 -O3 ./bitpacked-record.cpp
+ */
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "bitpacked_record.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define NEVER_INLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NEVER_INLINE __declspec(noinline)
+#else
+#define NEVER_INLINE
+#endif
+
+enum class color : std::uint8_t { red, green, blue, cyan, magenta };
+
+using record = bitpacked_record<
+    typelist<field<color, 3>, field<std::uint16_t, 11>, field<bool, 1>>>;
+
+// 3 + 11 + 20 + 40 = 74 bits, so the last field spans two 64-bit words
+using wide_record = bitpacked_record<
+    typelist<field<std::uint8_t, 3>, field<std::uint16_t, 11>,
+             field<std::int32_t, 20>, field<std::int64_t, 40>>>;
+
+void record_example() {
+  static_assert(sizeof(record) == 2, "");
+  static_assert(sizeof(record) < sizeof(std::tuple<color, std::uint16_t, bool>),
+                "");
+  static_assert(record::bit_count == 15, "");
+  static_assert(sizeof(wide_record) == 16 and wide_record::word_count == 2, "");
+  static_assert(std::is_trivially_copyable<record>::value, "");
+
+  constexpr record constant{color::blue, 2000, true};
+  static_assert(get<0>(constant) == color::blue, "");
+  static_assert(get<1>(constant) == 2000, "");
+  static_assert(get<2>(constant), "");
+
+  record r{};
+  assert(get<0>(r) == color::red and get<1>(r) == 0 and not get<2>(r));
+  set<1>(r, 2047);
+  set<0>(r, color::magenta);
+  assert(get<0>(r) == color::magenta and get<1>(r) == 2047 and not get<2>(r));
+  // Values are truncated to the bits of their field
+  set<1>(r, 2048 + 5);
+  assert(get<1>(r) == 5 and get<0>(r) == color::magenta);
+  assert(r != constant);
+  assert((record{color::blue, 2000, true} == constant));
+
+  // Signed fields are sign extended, also across two words
+  wide_record w{7, 1234, -524288, -549755813888};
+  assert(get<0>(w) == 7 and get<1>(w) == 1234);
+  assert(get<2>(w) == -524288 and get<3>(w) == -549755813888);
+  set<3>(w, 549755813887);
+  set<2>(w, 524287);
+  assert(get<2>(w) == 524287 and get<3>(w) == 549755813887);
+  assert(get<0>(w) == 7 and get<1>(w) == 1234);
+  set<3>(w, -1);
+  assert(get<3>(w) == -1 and get<2>(w) == 524287);
+
+  // Iterating with tuple_counted_fold
+  std::string fields{};
+  tuple_counted_fold(
+      w,
+      [](const auto& value, const size_t index, std::string& state) {
+        state += std::to_string(index) + "=" +
+                 std::to_string(static_cast<long long>(value)) + " ";
+      },
+      fields);
+  assert(fields == "0=7 1=1234 2=524287 3=-1 ");
+}
+
+void vector_example() {
+  bitpacked_vector<typelist<field<color, 3>, field<std::uint16_t, 11>,
+                            field<bool, 1>>>
+      v;
+  for (std::uint16_t i = 0; i < 1000; ++i) {
+    v.emplace_back(static_cast<color>(i % 5), static_cast<std::uint16_t>(i),
+                   i % 3 == 0);
+  }
+  assert(v.size() == 1000);
+  std::vector<color> colors(v.size());
+  std::vector<std::uint16_t> counts(v.size());
+  bool flags[1000];
+  unpack_all(v, colors.data(), counts.data(), flags);
+  for (std::uint16_t i = 0; i < 1000; ++i) {
+    assert(colors[i] == static_cast<color>(i % 5));
+    assert(counts[i] == i);
+    assert(flags[i] == (i % 3 == 0));
+  }
+  set<1>(v[10], 5);
+  unpack<1>(v, counts.data());
+  assert(counts[10] == 5);
+}
+
+using packed_row =
+    typelist<field<std::uint8_t, 3>, field<std::uint16_t, 12>,
+             field<std::int8_t, 5>, field<std::uint8_t, 4>>;
+
+NEVER_INLINE void unpack_packed(const bitpacked_vector<packed_row>& v,
+                                std::uint8_t* a, std::uint16_t* b,
+                                std::int8_t* c, std::uint8_t* d) {
+  unpack_all(v, a, b, c, d);
+}
+
+NEVER_INLINE void unpack_tuples(
+    const std::vector<
+        std::tuple<std::uint8_t, std::uint16_t, std::int8_t, std::uint8_t>>& v,
+    std::uint8_t* a, std::uint16_t* b, std::int8_t* c, std::uint8_t* d) {
+  for (size_t i = 0; i < v.size(); ++i) {
+    a[i] = std::get<0>(v[i]);
+    b[i] = std::get<1>(v[i]);
+    c[i] = std::get<2>(v[i]);
+    d[i] = std::get<3>(v[i]);
+  }
+}
+
+template <class F>
+double ns_per_row(const size_t rows, F&& f) {
+  size_t repetitions = 1;
+  while (true) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      f();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double elapsed_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    if (elapsed_ns > 5.0e7) {
+      return elapsed_ns / static_cast<double>(repetitions * rows);
+    }
+    repetitions *= 2;
+  }
+}
+
+// Compares unpacking 24-bit records into four arrays with unpacking a vector
+// of std::tuple of the same fields
+void unpack_benchmark() {
+  const size_t rows = 1 << 16;
+  std::mt19937 generator(42);
+  bitpacked_vector<packed_row> packed{};
+  std::vector<std::tuple<std::uint8_t, std::uint16_t, std::int8_t,
+                         std::uint8_t>>
+      tuples{};
+  for (size_t i = 0; i < rows; ++i) {
+    const auto a = static_cast<std::uint8_t>(generator() % 8);
+    const auto b = static_cast<std::uint16_t>(generator() % 4096);
+    const auto c = static_cast<std::int8_t>(
+        static_cast<int>(generator() % 32) - 16);
+    const auto d = static_cast<std::uint8_t>(generator() % 16);
+    packed.emplace_back(a, b, c, d);
+    tuples.emplace_back(a, b, c, d);
+  }
+  std::vector<std::uint8_t> a(rows);
+  std::vector<std::uint16_t> b(rows);
+  std::vector<std::int8_t> c(rows);
+  std::vector<std::uint8_t> d(rows);
+  unpack_packed(packed, a.data(), b.data(), c.data(), d.data());
+  for (size_t i = 0; i < rows; ++i) {
+    assert(c[i] == std::get<2>(tuples[i]));
+  }
+
+  std::printf("%-24s %8s %12s\n", "layout", "bytes", "ns/row");
+  std::printf("%-24s %8zu %12.3f\n", "bitpacked_vector",
+              sizeof(bitpacked_record<packed_row>),
+              ns_per_row(rows, [&]() {
+                unpack_packed(packed, a.data(), b.data(), c.data(), d.data());
+              }));
+  std::printf("%-24s %8zu %12.3f\n", "std::vector<std::tuple>",
+              sizeof(tuples[0]), ns_per_row(rows, [&]() {
+                unpack_tuples(tuples, a.data(), b.data(), c.data(), d.data());
+              }));
+}
+
+int main() {
+  record_example();
+  vector_example();
+  unpack_benchmark();
+}
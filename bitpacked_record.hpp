@@ -0,0 +1,383 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tuple_fold.hpp"
+#include "typelist.hpp"
+
+/*!
+ * \brief A field of a bitpacked_record holding a `T`, which is an integral or
+ * enum type, in `Bits` bits.
+ *
+ * Signed fields hold values from \f$-2^{Bits-1}\f$ to \f$2^{Bits-1}-1\f$,
+ * unsigned fields values below \f$2^{Bits}\f$.
+ */
+template <typename T, size_t Bits>
+struct field {
+  static_assert(std::is_integral<T>::value or std::is_enum<T>::value,
+                "A field must hold an integral or enum type");
+  static_assert(Bits > 0 and Bits <= 8 * sizeof(T),
+                "A field needs between 1 bit and the bits of its type");
+  using type = T;
+  static constexpr size_t bits = Bits;
+};
+
+namespace bitpacked_detail {
+template <typename T, bool = std::is_enum<T>::value>
+struct integer_of {
+  using type = std::underlying_type_t<T>;
+};
+
+template <typename T>
+struct integer_of<T, false> {
+  using type = T;
+};
+
+template <typename T>
+using integer_of_t = typename integer_of<T>::type;
+
+// The smallest unsigned integer holding all the bits, or 64-bit words if none
+// does
+template <size_t Bits>
+using word_type = std::conditional_t<
+    Bits <= 8, std::uint8_t,
+    std::conditional_t<
+        Bits <= 16, std::uint16_t,
+        std::conditional_t<Bits <= 32, std::uint32_t, std::uint64_t>>>;
+
+template <size_t Bits>
+constexpr std::uint64_t mask =
+    Bits == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << Bits) - 1;
+
+template <typename... Fields>
+struct layout {
+  static constexpr size_t bits[] = {Fields::bits...};
+
+  static constexpr size_t offset(const size_t index) {
+    size_t result = 0;
+    for (size_t i = 0; i < index; ++i) {
+      result += bits[i];
+    }
+    return result;
+  }
+
+  static constexpr size_t total_bits = offset(sizeof...(Fields));
+  using word = word_type<total_bits>;
+  static constexpr size_t word_bits = 8 * sizeof(word);
+  static constexpr size_t word_count = (total_bits + word_bits - 1) / word_bits;
+};
+
+// The `Bits` bits at `Offset` of the words, in the low bits. A field only
+// spans two words when the words are 64 bits.
+template <size_t Offset, size_t Bits, typename Word>
+constexpr std::uint64_t extract(const Word* const words) {
+  constexpr size_t word_bits = 8 * sizeof(Word);
+  constexpr size_t first = Offset / word_bits;
+  constexpr size_t shift = Offset % word_bits;
+  if constexpr (shift + Bits <= word_bits) {
+    return (static_cast<std::uint64_t>(words[first]) >> shift) & mask<Bits>;
+  } else {
+    return ((static_cast<std::uint64_t>(words[first]) >> shift) |
+            (static_cast<std::uint64_t>(words[first + 1])
+             << (word_bits - shift))) &
+           mask<Bits>;
+  }
+}
+
+template <size_t Offset, size_t Bits, typename Word>
+constexpr void insert(Word* const words, std::uint64_t value) {
+  constexpr size_t word_bits = 8 * sizeof(Word);
+  constexpr size_t first = Offset / word_bits;
+  constexpr size_t shift = Offset % word_bits;
+  value &= mask<Bits>;
+  if constexpr (shift + Bits <= word_bits) {
+    words[first] = static_cast<Word>(
+        (words[first] & ~static_cast<Word>(mask<Bits> << shift)) |
+        (value << shift));
+  } else {
+    constexpr size_t low_bits = word_bits - shift;
+    words[first] = static_cast<Word>(
+        (words[first] & mask<shift>) | (value << shift));
+    words[first + 1] = static_cast<Word>(
+        (words[first + 1] & ~mask<Bits - low_bits>) | (value >> low_bits));
+  }
+}
+
+// Converts the low `Bits` bits to a `T`, sign extending them for signed types
+template <typename T, size_t Bits>
+constexpr T to_field(const std::uint64_t raw) {
+  using integer = integer_of_t<T>;
+  if constexpr (std::is_signed<integer>::value and
+                Bits < 8 * sizeof(integer)) {
+    using unsigned_integer = std::make_unsigned_t<integer>;
+    constexpr unsigned_integer sign = unsigned_integer{1} << (Bits - 1);
+    const unsigned_integer x = static_cast<unsigned_integer>(raw);
+    return static_cast<T>(static_cast<integer>((x ^ sign) - sign));
+  } else {
+    return static_cast<T>(static_cast<integer>(raw));
+  }
+}
+
+template <typename T>
+constexpr std::uint64_t from_field(const T value) {
+  using integer = integer_of_t<T>;
+  if constexpr (std::is_same<integer, bool>::value) {
+    return value ? 1 : 0;
+  } else {
+    using unsigned_integer = std::make_unsigned_t<integer>;
+    return static_cast<std::uint64_t>(
+        static_cast<unsigned_integer>(static_cast<integer>(value)));
+  }
+}
+
+template <size_t I, typename... Ts>
+using nth = std::tuple_element_t<I, std::tuple<Ts...>>;
+}  // namespace bitpacked_detail
+
+template <typename FieldList>
+class bitpacked_record;
+
+/*!
+ * \brief A record of small integral and enum fields packed bit by bit into
+ * the smallest unsigned integer that holds them all, or into 64-bit words.
+ *
+ * The bit offsets of the fields are computed at compile time, so get and set
+ * compile to a few shifts and masks. Values that do not fit in their field are
+ * truncated to its bits. get, `std::tuple_size`, `std::tuple_element`,
+ * tuple_fold, tuple_counted_fold and tuple_transform treat a record as a
+ * tuple of the field types, with get returning the values by value.
+ *
+ * \code
+ * using record = bitpacked_record<
+ *     typelist<field<std::uint8_t, 3>, field<std::uint16_t, 11>>>;
+ * static_assert(sizeof(record) == 2, "");
+ * record r{5, 1000};
+ * set<1>(r, 17);
+ * \endcode
+ *
+ * \see bitpacked_vector
+ */
+template <typename... Fields>
+class bitpacked_record<typelist<Fields...>> {
+  static_assert(sizeof...(Fields) > 0, "A bitpacked_record needs fields");
+  using layout = bitpacked_detail::layout<Fields...>;
+
+ public:
+  using word_type = typename layout::word;
+  static constexpr size_t bit_count = layout::total_bits;
+  static constexpr size_t word_count = layout::word_count;
+
+  template <size_t I>
+  using type = typename bitpacked_detail::nth<I, Fields...>::type;
+
+  constexpr bitpacked_record() = default;
+
+  constexpr explicit bitpacked_record(const typename Fields::type... values) {
+    set_all(std::index_sequence_for<Fields...>{}, values...);
+  }
+
+  template <size_t I>
+  constexpr type<I> get() const {
+    using f = bitpacked_detail::nth<I, Fields...>;
+    return bitpacked_detail::to_field<type<I>, f::bits>(
+        bitpacked_detail::extract<layout::offset(I), f::bits>(words_));
+  }
+
+  template <size_t I>
+  constexpr void set(const type<I> value) {
+    using f = bitpacked_detail::nth<I, Fields...>;
+    bitpacked_detail::insert<layout::offset(I), f::bits>(
+        words_, bitpacked_detail::from_field(value));
+  }
+
+  constexpr const word_type* words() const { return words_; }
+
+  friend constexpr bool operator==(const bitpacked_record& a,
+                                   const bitpacked_record& b) {
+    for (size_t i = 0; i < word_count; ++i) {
+      if (a.words_[i] != b.words_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  friend constexpr bool operator!=(const bitpacked_record& a,
+                                   const bitpacked_record& b) {
+    return not(a == b);
+  }
+
+ private:
+  template <size_t... Is>
+  constexpr void set_all(std::index_sequence<Is...> /*meta*/,
+                         const typename Fields::type... values) {
+    static_cast<void>(std::initializer_list<char>{
+        (static_cast<void>(set<Is>(values)), '0')...});
+  }
+
+  word_type words_[word_count]{};
+};
+
+template <size_t I, typename FieldList>
+constexpr auto get(const bitpacked_record<FieldList>& record) {
+  return record.template get<I>();
+}
+
+template <size_t I, typename FieldList, typename T>
+constexpr void set(bitpacked_record<FieldList>& record, const T value) {
+  record.template set<I>(value);
+}
+
+namespace std {
+template <typename... Fields>
+struct tuple_size<bitpacked_record<typelist<Fields...>>>
+    : std::integral_constant<size_t, sizeof...(Fields)> {};
+
+template <size_t I, typename... Fields>
+struct tuple_element<I, bitpacked_record<typelist<Fields...>>> {
+  using type = typename bitpacked_detail::nth<I, Fields...>::type;
+};
+}  // namespace std
+
+template <bool ReverseIteration = false, typename... Fields, typename N_aryOp,
+          typename... Args>
+constexpr void tuple_fold(const bitpacked_record<typelist<Fields...>>& record,
+                          N_aryOp&& op, Args&&... args) {
+  tuple_impl_detail::tuple_fold_impl<ReverseIteration>(
+      record, std::forward<N_aryOp>(op),
+      std::make_index_sequence<sizeof...(Fields)>{}, args...);
+}
+
+template <bool ReverseIteration = false, typename... Fields, typename N_aryOp,
+          typename... Args>
+constexpr void tuple_counted_fold(
+    const bitpacked_record<typelist<Fields...>>& record, N_aryOp&& op,
+    Args&&... args) {
+  tuple_impl_detail::tuple_counted_fold_impl<ReverseIteration>(
+      record, std::forward<N_aryOp>(op),
+      std::make_index_sequence<sizeof...(Fields)>{}, args...);
+}
+
+template <bool ReverseIteration = false, typename... Fields, typename N_aryOp,
+          typename... Args>
+constexpr void tuple_transform(
+    const bitpacked_record<typelist<Fields...>>& record, N_aryOp&& op,
+    Args&&... args) {
+  tuple_impl_detail::tuple_transform_impl<ReverseIteration>(
+      record, std::forward<N_aryOp>(op),
+      std::make_index_sequence<sizeof...(Fields)>{}, args...);
+}
+
+/*!
+ * \brief A contiguous array of bitpacked_records.
+ *
+ * Each record takes the size of its word type (or words), so a record of 14
+ * bits takes 2 bytes. Records are not packed across word boundaries, which
+ * keeps every record at a fixed byte offset so that unpack and unpack_all
+ * read them with plain loads and their loops vectorize.
+ *
+ * \see unpack unpack_all
+ */
+template <typename FieldList>
+class bitpacked_vector {
+ public:
+  using record_type = bitpacked_record<FieldList>;
+
+  bitpacked_vector() = default;
+  explicit bitpacked_vector(const size_t size) : records_(size) {}
+
+  size_t size() const { return records_.size(); }
+  void reserve(const size_t capacity) { records_.reserve(capacity); }
+  void resize(const size_t size) { records_.resize(size); }
+
+  void push_back(const record_type& record) { records_.push_back(record); }
+
+  template <typename... Ts>
+  void emplace_back(const Ts... values) {
+    records_.emplace_back(values...);
+  }
+
+  const record_type& operator[](const size_t i) const { return records_[i]; }
+  record_type& operator[](const size_t i) { return records_[i]; }
+
+  const record_type* data() const { return records_.data(); }
+  record_type* data() { return records_.data(); }
+
+ private:
+  std::vector<record_type> records_;
+};
+
+/*!
+ * \brief Writes field `I` of every record of `vector` to `column`, which has
+ * room for `vector.size()` values.
+ */
+template <size_t I, typename FieldList>
+void unpack(
+    const bitpacked_vector<FieldList>& vector,
+    std::tuple_element_t<I, bitpacked_record<FieldList>>* const column) {
+  const bitpacked_record<FieldList>* const records = vector.data();
+  const size_t size = vector.size();
+  for (size_t i = 0; i < size; ++i) {
+    column[i] = get<I>(records[i]);
+  }
+}
+
+namespace bitpacked_detail {
+template <typename FieldList, typename... Ts, size_t... Is>
+void unpack_all(const bitpacked_vector<FieldList>& vector,
+                std::index_sequence<Is...> /*meta*/, Ts* const... columns) {
+  static_cast<void>(std::initializer_list<char>{
+      (static_cast<void>(unpack<Is>(vector, columns)), '0')...});
+}
+}  // namespace bitpacked_detail
+
+/*!
+ * \brief Unpacks every field of `vector` into its own array (structure of
+ * arrays), one field at a time.
+ *
+ * \code
+ * std::vector<std::uint8_t> a(v.size());
+ * std::vector<std::uint16_t> b(v.size());
+ * unpack_all(v, a.data(), b.data());
+ * \endcode
+ */
+template <typename... Fields>
+void unpack_all(const bitpacked_vector<typelist<Fields...>>& vector,
+                typename Fields::type* const... columns) {
+  bitpacked_detail::unpack_all(vector, std::index_sequence_for<Fields...>{},
+                               columns...);
+}
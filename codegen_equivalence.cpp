@@ -0,0 +1,182 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Pairs of kernels, each using for_constexpr, tuple_fold, tuple_counted_fold
+ * or tuple_transform next to the equivalent hand-written code. The kernels
+ * named `<name>_abstraction` and `<name>_handwritten` must compile to the same
+ * instructions, which is checked by `codegen_equivalence.sh`.
+ *
+ * Only compiled to an object file, there is no main. To check the code
+ * generation run:
+ * ./codegen_equivalence.sh
+ */
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+
+#include "for_constexpr.hpp"
+#include "tuple_fold.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define NEVER_INLINE __attribute__((noinline))
+#else
+#define NEVER_INLINE
+#endif
+
+using vector3 = std::array<double, 3>;
+using matrix3 = std::array<vector3, 3>;
+using mixed_tuple = std::tuple<int, double, float, long>;
+
+extern "C" {
+NEVER_INLINE void single_loop_abstraction(vector3& values) {
+  for_constexpr<for_bounds<0, 3>>([&values](auto i) { values[i] += 1.0; });
+}
+
+NEVER_INLINE void single_loop_handwritten(vector3& values) {
+  values[0] += 1.0;
+  values[1] += 1.0;
+  values[2] += 1.0;
+}
+
+NEVER_INLINE void double_loop_abstraction(matrix3& result, const vector3& a,
+                                          const vector3& b) {
+  for_constexpr<for_bounds<0, 3>, for_bounds<0, 3>>(
+      [&result, &a, &b](auto i, auto j) { result[i][j] = a[i] * b[j]; });
+}
+
+NEVER_INLINE void double_loop_handwritten(matrix3& result, const vector3& a,
+                                          const vector3& b) {
+  result[0][0] = a[0] * b[0];
+  result[0][1] = a[0] * b[1];
+  result[0][2] = a[0] * b[2];
+  result[1][0] = a[1] * b[0];
+  result[1][1] = a[1] * b[1];
+  result[1][2] = a[1] * b[2];
+  result[2][0] = a[2] * b[0];
+  result[2][1] = a[2] * b[1];
+  result[2][2] = a[2] * b[2];
+}
+
+NEVER_INLINE void symm_lower_abstraction(matrix3& result, const vector3& a) {
+  for_constexpr<for_bounds<0, 3>, for_symm_lower<0, 0, 1>>(
+      [&result, &a](auto i, auto j) { result[i][j] += a[i] * a[j]; });
+}
+
+NEVER_INLINE void symm_lower_handwritten(matrix3& result, const vector3& a) {
+  result[0][0] += a[0] * a[0];
+  result[1][0] += a[1] * a[0];
+  result[1][1] += a[1] * a[1];
+  result[2][0] += a[2] * a[0];
+  result[2][1] += a[2] * a[1];
+  result[2][2] += a[2] * a[2];
+}
+
+NEVER_INLINE double symm_upper_lower_abstraction(const matrix3& m,
+                                                 const vector3& a) {
+  double sum = 0.0;
+  for_constexpr<for_bounds<0, 3>, for_symm_upper<0, 3>,
+                for_symm_lower<1, 0, 1>>(
+      [&sum, &m, &a](auto i, auto j, auto k) { sum += m[i][j] * a[k]; });
+  return sum;
+}
+
+NEVER_INLINE double symm_upper_lower_handwritten(const matrix3& m,
+                                                 const vector3& a) {
+  double sum = 0.0;
+  sum += m[0][0] * a[0];
+  sum += m[0][1] * a[0];
+  sum += m[0][1] * a[1];
+  sum += m[0][2] * a[0];
+  sum += m[0][2] * a[1];
+  sum += m[0][2] * a[2];
+  sum += m[1][1] * a[0];
+  sum += m[1][1] * a[1];
+  sum += m[1][2] * a[0];
+  sum += m[1][2] * a[1];
+  sum += m[1][2] * a[2];
+  sum += m[2][2] * a[0];
+  sum += m[2][2] * a[1];
+  sum += m[2][2] * a[2];
+  return sum;
+}
+
+NEVER_INLINE double tuple_fold_abstraction(const mixed_tuple& t) {
+  double sum = 0.0;
+  tuple_fold(t, [](const auto& element, double& state) { state += element; },
+             sum);
+  return sum;
+}
+
+NEVER_INLINE double tuple_fold_handwritten(const mixed_tuple& t) {
+  double sum = 0.0;
+  sum += std::get<0>(t);
+  sum += std::get<1>(t);
+  sum += std::get<2>(t);
+  sum += static_cast<double>(std::get<3>(t));
+  return sum;
+}
+
+NEVER_INLINE double tuple_counted_fold_abstraction(const mixed_tuple& t) {
+  double sum = 0.0;
+  tuple_counted_fold(t,
+                     [](const auto& element, size_t index, double& state) {
+                       state += static_cast<double>(index) * element;
+                     },
+                     sum);
+  return sum;
+}
+
+NEVER_INLINE double tuple_counted_fold_handwritten(const mixed_tuple& t) {
+  double sum = 0.0;
+  sum += 0.0 * std::get<0>(t);
+  sum += 1.0 * std::get<1>(t);
+  sum += 2.0 * std::get<2>(t);
+  sum += 3.0 * static_cast<double>(std::get<3>(t));
+  return sum;
+}
+
+NEVER_INLINE void tuple_transform_abstraction(const mixed_tuple& in,
+                                              mixed_tuple& out) {
+  tuple_transform(in,
+                  [](const auto& element, auto index, mixed_tuple& result) {
+                    std::get<decltype(index)::value>(result) = -element;
+                  },
+                  out);
+}
+
+NEVER_INLINE void tuple_transform_handwritten(const mixed_tuple& in,
+                                              mixed_tuple& out) {
+  std::get<0>(out) = -std::get<0>(in);
+  std::get<1>(out) = -std::get<1>(in);
+  std::get<2>(out) = -std::get<2>(in);
+  std::get<3>(out) = -std::get<3>(in);
+}
+}  // extern "C"
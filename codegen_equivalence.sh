@@ -0,0 +1,96 @@
+#!/bin/sh
+# Copyright 2017 Nils Deppe
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE or copy at http://boost.org/LICENSE_1_0.txt)
+#
+# Checks that each kernel in codegen_equivalence.cpp that uses for_constexpr or
+# the tuple utilities compiles to the same instructions as its hand-written
+# equivalent. Every compiler in $COMPILERS (default: g++ clang++) that is
+# installed is run at -O2 and -O3. Exits with a non-zero status if for any
+# pair the number of instructions or the calls made differ.
+#
+# Usage:
+# ./codegen_equivalence.sh
+# COMPILERS="g++-12 clang++-15" ./codegen_equivalence.sh
+
+set -u
+
+cd "$(dirname "$0")" || exit 1
+
+compilers=${COMPILERS:-"g++ clang++"}
+optimizations="-O2 -O3"
+kernels=$(sed -n 's/^NEVER_INLINE [a-z ]*[ ]\([a-z_]*\)_abstraction(.*/\1/p' \
+  codegen_equivalence.cpp)
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+# Disassembles one function, dropping addresses, encodings, comments and
+# padding, and replacing jump and call targets inside the function by their
+# offset so that identical code at different addresses compares equal.
+disassemble() {
+  objdump -d --no-show-raw-insn --disassemble="$2" "$1" |
+    awk -v name="$2" '
+      /^[ ]+[0-9a-f]+:\t/ {
+        sub(/^[ ]+[0-9a-f]+:\t/, "")
+        sub(/[ ]*#.*$/, "")
+        if ($0 ~ /^(nop|xchg +%ax,%ax|data16|cs nop)/) {
+          next
+        }
+        gsub(/[0-9a-f]+ <[^>]*>/, "<&>")
+        gsub(/<[0-9a-f]+ </, "<")
+        gsub(/>>/, ">")
+        gsub("<" name "\\+0x", "<+0x")
+        gsub("<" name ">", "<+0x0>")
+        print
+      }'
+}
+
+status=0
+checked=0
+for cxx in $compilers; do
+  if ! command -v "$cxx" > /dev/null 2>&1; then
+    echo "Skipping $cxx: not found"
+    continue
+  fi
+  for opt in $optimizations; do
+    object="$work_dir/kernels.o"
+    if ! "$cxx" -std=c++14 "$opt" -c codegen_equivalence.cpp -o "$object"; then
+      echo "FAIL: $cxx $opt: compilation failed"
+      status=1
+      continue
+    fi
+    for kernel in $kernels; do
+      disassemble "$object" "${kernel}_abstraction" \
+        | sed "s/${kernel}_abstraction/KERNEL/g" > "$work_dir/abstraction.s"
+      disassemble "$object" "${kernel}_handwritten" \
+        | sed "s/${kernel}_handwritten/KERNEL/g" > "$work_dir/handwritten.s"
+      abstraction_count=$(wc -l < "$work_dir/abstraction.s")
+      handwritten_count=$(wc -l < "$work_dir/handwritten.s")
+      abstraction_calls=$(grep -E '^(call|jmp +[0-9a-f]* *<[^+])' \
+        "$work_dir/abstraction.s")
+      handwritten_calls=$(grep -E '^(call|jmp +[0-9a-f]* *<[^+])' \
+        "$work_dir/handwritten.s")
+      checked=$((checked + 1))
+      if [ "$abstraction_count" -eq 0 ] ||
+        [ "$abstraction_count" -ne "$handwritten_count" ] ||
+        [ "$abstraction_calls" != "$handwritten_calls" ]; then
+        echo "FAIL: $cxx $opt $kernel: $abstraction_count instructions" \
+          "vs $handwritten_count hand-written"
+        diff -u "$work_dir/handwritten.s" "$work_dir/abstraction.s"
+        status=1
+      elif ! cmp -s "$work_dir/abstraction.s" "$work_dir/handwritten.s"; then
+        echo "ok:   $cxx $opt $kernel ($abstraction_count instructions," \
+          "differs only in registers or order)"
+      else
+        echo "ok:   $cxx $opt $kernel ($abstraction_count instructions)"
+      fi
+    done
+  done
+done
+
+if [ "$checked" -eq 0 ]; then
+  echo "No kernels were checked"
+  exit 1
+fi
+exit $status
@@ -0,0 +1,215 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+#include "for_constexpr.hpp"
+
+namespace fixed_kernels_detail {
+constexpr size_t min(const size_t a, const size_t b) { return a < b ? a : b; }
+
+constexpr size_t blocks(const size_t size, const size_t block) {
+  return (size + block - 1) / block;
+}
+
+// Called once per matrix in the batched kernels. When a whole unrolled kernel
+// is inlined into the loop over the matrices GCC can vectorize that loop
+// across matrices, with gathers of every element, which is several times
+// slower than the kernel vectorized on its own. An asm statement cannot be
+// vectorized, so this keeps the loop scalar without emitting any code.
+ALWAYS_INLINE void next_matrix() {
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+  asm volatile("");
+#endif
+}
+
+// Computes the Rows x Cols block `c = a * b`, where `a` is Rows x K with row
+// stride LdA, and element (k, j) of `b` is `b[k * BK + j * BJ]`. The
+// accumulators are a local array indexed only by compile time constants, so
+// that after for_constexpr is unrolled the compiler keeps them in registers
+// for the whole loop over `k` and stores each of them to `c` once.
+template <size_t Rows, size_t Cols, size_t K, size_t LdA, size_t BK,
+          size_t BJ, size_t LdC, class T>
+ALWAYS_INLINE void micro_kernel(const T* const a, const T* const b,
+                                T* const c) {
+  T acc[Rows][Cols]{};
+  for_constexpr<for_bounds<0, K>, for_bounds<0, Rows>, for_bounds<0, Cols>>(
+      [&acc, a, b](auto k, auto i, auto j) {
+        acc[i][j] += a[i * LdA + k] * b[k * BK + j * BJ];
+      });
+  for_constexpr<for_bounds<0, Rows>, for_bounds<0, Cols>>(
+      [&acc, c](auto i, auto j) { c[i * LdC + j] = acc[i][j]; });
+}
+}  // namespace fixed_kernels_detail
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Computes `c = a * b` for the row-major matrices `a` (M x K), `b`
+ * (K x N) and `c` (M x N), whose sizes are known at compile time.
+ *
+ * `c` is computed in blocks of `MR x NR` elements. All the loops are unrolled
+ * with for_constexpr, and each block is accumulated in registers over the
+ * whole sum over `k` before it is stored, instead of loading and storing `c`
+ * for every `k` as a loop over `c[i * N + j] += ...` does when the compiler
+ * cannot prove that `c` does not alias `a` or `b`. The default 4 x 8 blocks
+ * of doubles take 16 SSE or 8 AVX registers. `c` must not overlap `a` or `b`.
+ *
+ * \see gemm_fixed_batched gemv_fixed syrk_fixed
+ */
+template <size_t M, size_t N, size_t K, size_t MR = 4, size_t NR = 8, class T>
+void gemm_fixed(const T* const a, const T* const b, T* const c) {
+  using fixed_kernels_detail::blocks;
+  using fixed_kernels_detail::min;
+  for_constexpr<for_bounds<0, blocks(M, MR)>, for_bounds<0, blocks(N, NR)>>(
+      [a, b, c](auto block_i, auto block_j) {
+        constexpr size_t i0 = decltype(block_i)::value * MR;
+        constexpr size_t j0 = decltype(block_j)::value * NR;
+        fixed_kernels_detail::micro_kernel<min(MR, M - i0), min(NR, N - j0),
+                                           K, K, N, 1, N>(
+            a + i0 * K, b + j0, c + i0 * N + j0);
+      });
+}
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Computes `y = a * x` for the row-major M x N matrix `a`, in blocks
+ * of `MR` rows whose dot products are accumulated in registers together.
+ *
+ * Each row keeps `Lanes` partial sums of consecutive columns, so that every
+ * step of the unrolled loop is a contiguous load of `a` and `x` and one
+ * vector multiply-add, and the partial sums are added once at the end.
+ * Unlike gemm_fixed the result is therefore not summed in the order of a
+ * plain loop over the columns. Smaller row blocks make GCC vectorize across
+ * the rows instead, with strided loads of `a`, which is why the defaults are
+ * larger than those of gemm_fixed.
+ *
+ * \see gemm_fixed
+ */
+template <size_t M, size_t N, size_t MR = 8, size_t Lanes = 8, class T>
+void gemv_fixed(const T* const a, const T* const x, T* const y) {
+  using fixed_kernels_detail::blocks;
+  using fixed_kernels_detail::min;
+  for_constexpr<for_bounds<0, blocks(M, MR)>>([a, x, y](auto block_i) {
+    constexpr size_t i0 = decltype(block_i)::value * MR;
+    constexpr size_t rows = min(MR, M - i0);
+    T acc[rows][Lanes]{};
+    for_constexpr<for_bounds<0, N / Lanes>, for_bounds<0, rows>,
+                  for_bounds<0, Lanes>>(
+        [&acc, a, x](auto chunk, auto i, auto lane) {
+          constexpr size_t j = decltype(chunk)::value * Lanes + lane;
+          acc[i][lane] += a[(i0 + i) * N + j] * x[j];
+        });
+    for_constexpr<for_bounds<N - N % Lanes, N>, for_bounds<0, rows>>(
+        [&acc, a, x](auto j, auto i) {
+          acc[i][0] += a[(i0 + i) * N + j] * x[j];
+        });
+    for_constexpr<for_bounds<0, rows>>([&acc, y](auto i) {
+      T sum = acc[i][0];
+      for_constexpr<for_bounds<1, Lanes>>(
+          [&acc, &sum, i](auto lane) { sum += acc[i][lane]; });
+      y[i0 + i] = sum;
+    });
+  });
+}
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Computes the symmetric `c = a * transpose(a)` for the row-major
+ * N x K matrix `a`, writing all of the N x N matrix `c`.
+ *
+ * Only the blocks on and below the diagonal are computed, iterating over
+ * them with for_symm_lower, and each is also stored transposed above the
+ * diagonal. This takes about half the multiplications of gemm_fixed.
+ *
+ * \see gemm_fixed
+ */
+template <size_t N, size_t K, size_t NR = 4, class T>
+void syrk_fixed(const T* const a, T* const c) {
+  using fixed_kernels_detail::blocks;
+  using fixed_kernels_detail::min;
+  for_constexpr<for_bounds<0, blocks(N, NR)>, for_symm_lower<0, 0, 1>>(
+      [a, c](auto block_i, auto block_j) {
+        constexpr size_t i0 = decltype(block_i)::value * NR;
+        constexpr size_t j0 = decltype(block_j)::value * NR;
+        constexpr size_t rows = min(NR, N - i0);
+        constexpr size_t cols = min(NR, N - j0);
+        T block[rows * cols];
+        // Element (k, j) of transpose(a) is a[(j0 + j) * K + k]
+        fixed_kernels_detail::micro_kernel<rows, cols, K, K, 1, K, cols>(
+            a + i0 * K, a + j0 * K, block);
+        for_constexpr<for_bounds<0, rows>, for_bounds<0, cols>>(
+            [c, &block](auto i, auto j) {
+              c[(i0 + i) * N + j0 + j] = block[i * cols + j];
+              c[(j0 + j) * N + i0 + i] = block[i * cols + j];
+            });
+      });
+}
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Computes `c[m] = a[m] * b[m]` with gemm_fixed for `count` matrices
+ * stored one after another in each of the arrays `a`, `b` and `c`.
+ */
+template <size_t M, size_t N, size_t K, size_t MR = 4, size_t NR = 8, class T>
+void gemm_fixed_batched(const T* const a, const T* const b, T* const c,
+                        const size_t count) {
+  for (size_t m = 0; m < count; ++m) {
+    gemm_fixed<M, N, K, MR, NR>(a + m * M * K, b + m * K * N, c + m * M * N);
+    fixed_kernels_detail::next_matrix();
+  }
+}
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Computes `y[m] = a[m] * x[m]` with gemv_fixed for `count` matrices
+ * and vectors stored one after another.
+ */
+template <size_t M, size_t N, size_t MR = 8, size_t Lanes = 8, class T>
+void gemv_fixed_batched(const T* const a, const T* const x, T* const y,
+                        const size_t count) {
+  for (size_t m = 0; m < count; ++m) {
+    gemv_fixed<M, N, MR, Lanes>(a + m * M * N, x + m * N, y + m * M);
+    fixed_kernels_detail::next_matrix();
+  }
+}
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Computes `c[m] = a[m] * transpose(a[m])` with syrk_fixed for `count`
+ * matrices stored one after another.
+ */
+template <size_t N, size_t K, size_t NR = 4, class T>
+void syrk_fixed_batched(const T* const a, T* const c, const size_t count) {
+  for (size_t m = 0; m < count; ++m) {
+    syrk_fixed<N, K, NR>(a + m * N * K, c + m * N * N);
+    fixed_kernels_detail::next_matrix();
+  }
+}
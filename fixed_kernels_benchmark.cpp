@@ -0,0 +1,312 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compares gemm_fixed, gemv_fixed and syrk_fixed with runtime loops and with
+ * a for_constexpr loop accumulating directly into the output, for square
+ * matrices of size 2 to 16. Each kernel runs over a batch of matrices that
+ * fits in L2, and the time per matrix and the GFLOP/s are printed.
+ *
+ * Compile the code using:
+ * clang++ -std=c++14 -O3 -march=native ./fixed_kernels_benchmark.cpp
+ * g++ -std=c++14 -O3 -march=native ./fixed_kernels_benchmark.cpp
+ */
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "fixed_kernels.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define NEVER_INLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NEVER_INLINE __declspec(noinline)
+#else
+#define NEVER_INLINE
+#endif
+
+namespace {
+template <size_t M, size_t N, size_t K>
+void loops_gemm(const double* const a, const double* const b,
+                double* const c) {
+  for (size_t i = 0; i < M; ++i) {
+    for (size_t j = 0; j < N; ++j) {
+      c[i * N + j] = 0.0;
+      for (size_t k = 0; k < K; ++k) {
+        c[i * N + j] += a[i * K + k] * b[k * N + j];
+      }
+    }
+  }
+}
+
+template <size_t M, size_t N, size_t K>
+void naive_for_constexpr_gemm(const double* const a, const double* const b,
+                              double* const c) {
+  for_constexpr<for_bounds<0, M>, for_bounds<0, N>>(
+      [c](auto i, auto j) { c[i * N + j] = 0.0; });
+  for_constexpr<for_bounds<0, M>, for_bounds<0, N>, for_bounds<0, K>>(
+      [a, b, c](auto i, auto j, auto k) {
+        c[i * N + j] += a[i * K + k] * b[k * N + j];
+      });
+}
+
+template <size_t M, size_t N>
+void loops_gemv(const double* const a, const double* const x,
+                double* const y) {
+  for (size_t i = 0; i < M; ++i) {
+    y[i] = 0.0;
+    for (size_t j = 0; j < N; ++j) {
+      y[i] += a[i * N + j] * x[j];
+    }
+  }
+}
+
+template <size_t N, size_t K>
+void loops_syrk(const double* const a, double* const c) {
+  for (size_t i = 0; i < N; ++i) {
+    for (size_t j = 0; j <= i; ++j) {
+      c[i * N + j] = 0.0;
+      for (size_t k = 0; k < K; ++k) {
+        c[i * N + j] += a[i * K + k] * a[j * K + k];
+      }
+      c[j * N + i] = c[i * N + j];
+    }
+  }
+}
+
+template <size_t M, size_t N, size_t K>
+void check_kernels(std::mt19937& generator) {
+  std::uniform_real_distribution<double> value(-1.0, 1.0);
+  std::vector<double> a(M * K);
+  std::vector<double> b(K * N);
+  std::vector<double> x(K);
+  for (auto& v : a) {
+    v = value(generator);
+  }
+  for (auto& v : b) {
+    v = value(generator);
+  }
+  for (auto& v : x) {
+    v = value(generator);
+  }
+  std::vector<double> expected(M * N);
+  std::vector<double> c(M * N);
+  loops_gemm<M, N, K>(a.data(), b.data(), expected.data());
+  gemm_fixed<M, N, K>(a.data(), b.data(), c.data());
+  for (size_t i = 0; i < M * N; ++i) {
+    assert(std::abs(c[i] - expected[i]) < 1.0e-12);
+  }
+  // Blocks that do not divide the sizes
+  gemm_fixed<M, N, K, 3, 5>(a.data(), b.data(), c.data());
+  for (size_t i = 0; i < M * N; ++i) {
+    assert(std::abs(c[i] - expected[i]) < 1.0e-12);
+  }
+
+  std::vector<double> expected_y(M);
+  std::vector<double> y(M);
+  loops_gemv<M, K>(a.data(), x.data(), expected_y.data());
+  gemv_fixed<M, K>(a.data(), x.data(), y.data());
+  for (size_t i = 0; i < M; ++i) {
+    assert(std::abs(y[i] - expected_y[i]) < 1.0e-12);
+  }
+
+  std::vector<double> expected_syrk(M * M);
+  std::vector<double> syrk(M * M);
+  loops_syrk<M, K>(a.data(), expected_syrk.data());
+  syrk_fixed<M, K>(a.data(), syrk.data());
+  for (size_t i = 0; i < M * M; ++i) {
+    assert(std::abs(syrk[i] - expected_syrk[i]) < 1.0e-12);
+  }
+  syrk_fixed<M, K, 3>(a.data(), syrk.data());
+  for (size_t i = 0; i < M * M; ++i) {
+    assert(std::abs(syrk[i] - expected_syrk[i]) < 1.0e-12);
+  }
+
+  const size_t count = 5;
+  std::vector<double> as(count * M * K);
+  std::vector<double> bs(count * K * N);
+  std::vector<double> cs(count * M * N);
+  for (auto& v : as) {
+    v = value(generator);
+  }
+  for (auto& v : bs) {
+    v = value(generator);
+  }
+  gemm_fixed_batched<M, N, K>(as.data(), bs.data(), cs.data(), count);
+  loops_gemm<M, N, K>(as.data() + 4 * M * K, bs.data() + 4 * K * N,
+                      expected.data());
+  for (size_t i = 0; i < M * N; ++i) {
+    assert(std::abs(cs[4 * M * N + i] - expected[i]) < 1.0e-12);
+  }
+}
+
+template <class F>
+double ns_per_call(const size_t calls, F&& f) {
+  size_t repetitions = 1;
+  while (true) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      f();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double elapsed_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    if (elapsed_ns > 5.0e7) {
+      return elapsed_ns / static_cast<double>(repetitions * calls);
+    }
+    repetitions *= 2;
+  }
+}
+
+// Each kernel is a separate non-inlined function over the whole batch, as it
+// would be called in an application
+template <size_t N>
+NEVER_INLINE void batch_loops_gemm(const double* a, const double* b,
+                                   double* c, const size_t count) {
+  for (size_t m = 0; m < count; ++m) {
+    loops_gemm<N, N, N>(a + m * N * N, b + m * N * N, c + m * N * N);
+  }
+}
+
+template <size_t N>
+NEVER_INLINE void batch_naive_gemm(const double* a, const double* b,
+                                   double* c, const size_t count) {
+  for (size_t m = 0; m < count; ++m) {
+    naive_for_constexpr_gemm<N, N, N>(a + m * N * N, b + m * N * N,
+                                      c + m * N * N);
+  }
+}
+
+template <size_t N>
+NEVER_INLINE void batch_fixed_gemm(const double* a, const double* b,
+                                   double* c, const size_t count) {
+  gemm_fixed_batched<N, N, N>(a, b, c, count);
+}
+
+template <size_t N>
+NEVER_INLINE void batch_loops_gemv(const double* a, const double* x,
+                                   double* y, const size_t count) {
+  for (size_t m = 0; m < count; ++m) {
+    loops_gemv<N, N>(a + m * N * N, x + m * N, y + m * N);
+  }
+}
+
+template <size_t N>
+NEVER_INLINE void batch_fixed_gemv(const double* a, const double* x,
+                                   double* y, const size_t count) {
+  gemv_fixed_batched<N, N>(a, x, y, count);
+}
+
+template <size_t N>
+NEVER_INLINE void batch_loops_syrk(const double* a, double* c,
+                                   const size_t count) {
+  for (size_t m = 0; m < count; ++m) {
+    loops_syrk<N, N>(a + m * N * N, c + m * N * N);
+  }
+}
+
+template <size_t N>
+NEVER_INLINE void batch_fixed_syrk(const double* a, double* c,
+                                   const size_t count) {
+  syrk_fixed_batched<N, N>(a, c, count);
+}
+
+template <size_t N>
+void benchmark(std::mt19937& generator) {
+  // About 192 KiB for the three arrays of matrices
+  const size_t count = 8192 / (N * N) + 1;
+  std::uniform_real_distribution<double> value(-1.0, 1.0);
+  std::vector<double> a(count * N * N);
+  std::vector<double> b(count * N * N);
+  std::vector<double> c(count * N * N);
+  for (auto& v : a) {
+    v = value(generator);
+  }
+  for (auto& v : b) {
+    v = value(generator);
+  }
+  const double gemm_flops = 2.0 * N * N * N;
+  const double gemv_flops = 2.0 * N * N;
+  const double syrk_flops = N * (N + 1.0) * N;
+  const auto print = [](const char* name, const double ns,
+                        const double flops) {
+    std::printf("  %-24s %10.2f %8.2f\n", name, ns, flops / ns);
+  };
+  std::printf("%zu x %zu, %zu matrices          ns/matrix  GFLOP/s\n", N, N,
+              count);
+  print("gemm loops", ns_per_call(count, [&]() {
+          batch_loops_gemm<N>(a.data(), b.data(), c.data(), count);
+        }),
+        gemm_flops);
+  print("gemm naive for_constexpr", ns_per_call(count, [&]() {
+          batch_naive_gemm<N>(a.data(), b.data(), c.data(), count);
+        }),
+        gemm_flops);
+  print("gemm_fixed", ns_per_call(count, [&]() {
+          batch_fixed_gemm<N>(a.data(), b.data(), c.data(), count);
+        }),
+        gemm_flops);
+  print("gemv loops", ns_per_call(count, [&]() {
+          batch_loops_gemv<N>(a.data(), b.data(), c.data(), count);
+        }),
+        gemv_flops);
+  print("gemv_fixed", ns_per_call(count, [&]() {
+          batch_fixed_gemv<N>(a.data(), b.data(), c.data(), count);
+        }),
+        gemv_flops);
+  print("syrk loops", ns_per_call(count, [&]() {
+          batch_loops_syrk<N>(a.data(), c.data(), count);
+        }),
+        syrk_flops);
+  print("syrk_fixed", ns_per_call(count, [&]() {
+          batch_fixed_syrk<N>(a.data(), c.data(), count);
+        }),
+        syrk_flops);
+}
+}  // namespace
+
+int main() {
+  std::mt19937 generator(42);
+  check_kernels<1, 1, 1>(generator);
+  check_kernels<2, 3, 4>(generator);
+  check_kernels<7, 5, 3>(generator);
+  check_kernels<16, 16, 16>(generator);
+
+  benchmark<2>(generator);
+  benchmark<3>(generator);
+  benchmark<4>(generator);
+  benchmark<8>(generator);
+  benchmark<12>(generator);
+  benchmark<16>(generator);
+}
@@ -0,0 +1,537 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compile the code using:
+ * clang++ -std=c++17 -O3 ./flat-map-lookup.cpp
+ * g++ -std=c++17 -O3 ./flat-map-lookup.cpp
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "overloader.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define PREFETCH(address) __builtin_prefetch(address)
+#else
+#define PREFETCH(address) static_cast<void>(address)
+#endif
+
+template <class Trait, class... Type>
+constexpr bool local_trait_v =
+    decltype(std::declval<Trait>()(std::declval<Type>()..., 0))::value;
+
+/*
+ * A map stored as two sorted contiguous arrays, one of keys and one of values.
+ * Lookups only touch the key array. A copy of the keys in Eytzinger (BFS)
+ * order is kept so that searches can be done branchlessly with the next levels
+ * of the tree prefetched.
+ *
+ * Inserting a single element is O(N). Use `insert_bulk` to insert many
+ * elements at once, which sorts the new elements and merges them in O(N + M
+ * log M).
+ */
+template <class Key, class T, class Compare = std::less<Key>>
+class flat_map {
+ public:
+  using key_type = Key;
+  using mapped_type = T;
+  using key_compare = Compare;
+  using size_type = size_t;
+
+  flat_map() = default;
+
+  explicit flat_map(std::vector<std::pair<Key, T>> elements,
+                    Compare compare = Compare{})
+      : compare_(std::move(compare)) {
+    insert_bulk(std::move(elements));
+  }
+
+  size_type size() const { return keys_.size(); }
+  key_compare key_comp() const { return compare_; }
+  bool empty() const { return keys_.empty(); }
+
+  const std::vector<Key>& keys() const { return keys_; }
+  const std::vector<T>& values() const { return values_; }
+
+  // Returns a pointer to the value associated with `key`, or `nullptr` if
+  // there is no such value.
+  const T* find(const Key& key) const {
+    const size_t k = eytzinger_lower_bound(key);
+    return (k != 0 and not compare_(key, eytzinger_keys_[k]))
+               ? &values_[eytzinger_index_[k]]
+               : nullptr;
+  }
+
+  T* find(const Key& key) {
+    return const_cast<T*>(static_cast<const flat_map&>(*this).find(key));
+  }
+
+  size_type count(const Key& key) const { return find(key) != nullptr; }
+
+  T& operator[](const Key& key) {
+    T* const value = find(key);
+    return value != nullptr ? *value : *insert(key, T{}).first;
+  }
+
+  std::pair<T*, bool> insert(const Key& key, T value) {
+    const auto it = std::lower_bound(keys_.begin(), keys_.end(), key, compare_);
+    const auto index = static_cast<size_t>(it - keys_.begin());
+    if (it != keys_.end() and not compare_(key, *it)) {
+      return {&values_[index], false};
+    }
+    keys_.insert(it, key);
+    values_.insert(values_.begin() + static_cast<std::ptrdiff_t>(index),
+                   std::move(value));
+    build_eytzinger();
+    return {&values_[index], true};
+  }
+
+  // Inserts all `elements` that are not already in the map. If a key appears
+  // more than once in `elements` the first occurrence is kept.
+  void insert_bulk(std::vector<std::pair<Key, T>> elements) {
+    std::stable_sort(elements.begin(), elements.end(),
+                     [this](const auto& a, const auto& b) {
+                       return compare_(a.first, b.first);
+                     });
+    std::vector<Key> keys;
+    std::vector<T> values;
+    keys.reserve(keys_.size() + elements.size());
+    values.reserve(keys_.size() + elements.size());
+    size_t i = 0;
+    size_t j = 0;
+    const auto push_back_unique = [this, &keys, &values](const Key& key,
+                                                         T&& value) {
+      if (keys.empty() or compare_(keys.back(), key)) {
+        keys.push_back(key);
+        values.push_back(std::move(value));
+      }
+    };
+    while (i < keys_.size() or j < elements.size()) {
+      if (j == elements.size() or
+          (i < keys_.size() and
+           not compare_(elements[j].first, keys_[i]))) {
+        push_back_unique(keys_[i], std::move(values_[i]));
+        ++i;
+      } else {
+        push_back_unique(elements[j].first, std::move(elements[j].second));
+        ++j;
+      }
+    }
+    keys_ = std::move(keys);
+    values_ = std::move(values);
+    build_eytzinger();
+  }
+
+  // Returns the index into `eytzinger_keys_` of the first key not less than
+  // `key`, or zero if all keys are less than `key`. The loop has no branches
+  // other than the loop condition, whose trip count only depends on `size()`.
+  size_t eytzinger_lower_bound(const Key& key) const {
+    constexpr size_t keys_per_line = 64 / sizeof(Key) > 0 ? 64 / sizeof(Key) : 1;
+    const size_t n = keys_.size();
+    const Key* const tree = eytzinger_keys_.data();
+    size_t k = 1;
+    while (k <= n) {
+      PREFETCH(tree + std::min(k * keys_per_line, n));
+      k = 2 * k + static_cast<size_t>(compare_(tree[k], key));
+    }
+    // Undo the right turns taken after the last left turn.
+    return k >> (count_trailing_ones(k) + 1);
+  }
+
+  const Key& eytzinger_key(const size_t k) const { return eytzinger_keys_[k]; }
+  const T& eytzinger_value(const size_t k) const {
+    return values_[eytzinger_index_[k]];
+  }
+
+ private:
+  static size_t count_trailing_ones(size_t k) {
+    size_t count = 0;
+    while ((k & 1) != 0) {
+      k >>= 1;
+      ++count;
+    }
+    return count;
+  }
+
+  void build_eytzinger() {
+    eytzinger_keys_.resize(keys_.size() + 1);
+    eytzinger_index_.resize(keys_.size() + 1);
+    build_eytzinger_impl(0, 1);
+  }
+
+  size_t build_eytzinger_impl(size_t i, const size_t k) {
+    if (k <= keys_.size()) {
+      i = build_eytzinger_impl(i, 2 * k);
+      eytzinger_keys_[k] = keys_[i];
+      eytzinger_index_[k] = i;
+      i = build_eytzinger_impl(i + 1, 2 * k + 1);
+    }
+    return i;
+  }
+
+  Compare compare_{};
+  std::vector<Key> keys_{};
+  std::vector<T> values_{};
+  // One-based so that the children of node k are 2k and 2k+1
+  std::vector<Key> eytzinger_keys_{Key{}};
+  std::vector<size_t> eytzinger_index_{0};
+};
+
+namespace lookup_detail {
+struct tree_search {};
+struct binary_search {};
+struct eytzinger_search {};
+struct hashed_prefetch_search {};
+
+template <class Container>
+constexpr auto lookup_strategy() {
+  constexpr auto is_std_map = make_overloader(
+      [](auto t, int) -> std::enable_if_t<
+          std::is_same<decltype(t),
+                       std::map<typename decltype(t)::key_type,
+                                typename decltype(t)::mapped_type,
+                                typename decltype(t)::key_compare,
+                                typename decltype(t)::allocator_type>>::value,
+          std::true_type> { return std::true_type{}; },
+      [](auto...) { return std::false_type{}; });
+  constexpr auto is_std_unordered_map = make_overloader(
+      [](auto t, int) -> std::enable_if_t<
+          std::is_same<decltype(t),
+                       std::unordered_map<typename decltype(t)::key_type,
+                                          typename decltype(t)::mapped_type,
+                                          typename decltype(t)::hasher,
+                                          typename decltype(t)::key_equal,
+                                          typename decltype(t)::allocator_type>>::
+              value,
+          std::true_type> { return std::true_type{}; },
+      [](auto...) { return std::false_type{}; });
+  constexpr auto is_flat_map = make_overloader(
+      [](auto t, int) -> std::enable_if_t<
+          std::is_same<
+              decltype(t),
+              flat_map<typename decltype(t)::key_type,
+                       typename decltype(t)::mapped_type,
+                       typename decltype(t)::key_compare>>::value,
+          std::true_type> { return std::true_type{}; },
+      [](auto...) { return std::false_type{}; });
+  constexpr auto is_std_vector = make_overloader(
+      [](auto t, int) -> std::enable_if_t<
+          std::is_same<decltype(t),
+                       std::vector<typename decltype(t)::value_type,
+                                   typename decltype(t)::allocator_type>>::value,
+          std::true_type> { return std::true_type{}; },
+      [](auto...) { return std::false_type{}; });
+
+  if constexpr (local_trait_v<decltype(is_flat_map), Container>) {
+    return eytzinger_search{};
+  } else if constexpr (local_trait_v<decltype(is_std_unordered_map),
+                                     Container>) {
+    return hashed_prefetch_search{};
+  } else if constexpr (local_trait_v<decltype(is_std_vector), Container>) {
+    return binary_search{};
+  } else {
+    static_assert(local_trait_v<decltype(is_std_map), Container>,
+                  "best_lookup supports std::map, std::unordered_map, "
+                  "flat_map, and sorted std::vector");
+    return tree_search{};
+  }
+}
+
+// Branchless lower bound on a range sorted by `compare`. The compiler turns
+// the conditional into a conditional move.
+template <class T, class Compare>
+const T* branchless_lower_bound(const T* base, size_t size, const T& key,
+                                const Compare& compare) {
+  if (size == 0) {
+    return base;
+  }
+  while (size > 1) {
+    const size_t half = size / 2;
+    base = compare(base[half - 1], key) ? base + half : base;
+    size -= half;
+  }
+  return base + static_cast<size_t>(compare(*base, key));
+}
+
+const auto lookup = make_overloader(
+    [](const auto& c, const auto& key, tree_search /*meta*/) {
+      const auto it = c.find(key);
+      return it != c.end() ? &it->second : nullptr;
+    },
+    [](const auto& c, const auto& key, hashed_prefetch_search /*meta*/) {
+      const auto it = c.find(key);
+      return it != c.end() ? &it->second : nullptr;
+    },
+    [](const auto& c, const auto& key, eytzinger_search /*meta*/) {
+      return c.find(key);
+    },
+    [](const auto& c, const auto& key, binary_search /*meta*/) {
+      // std::vector has no comparator and must be sorted with operator<
+      const std::less<> compare{};
+      const auto* const end = c.data() + c.size();
+      const auto* const it =
+          branchless_lower_bound(c.data(), c.size(), key, compare);
+      return (it != end and not compare(key, *it)) ? it : nullptr;
+    });
+
+// Searches of the same depth are interleaved so that the cache misses of
+// different keys overlap.
+constexpr size_t bulk_block_size = 16;
+
+template <class Container, class Key, class Result>
+void bulk_lookup_impl(const Container& c, const Key* keys, const size_t size,
+                      Result* out, eytzinger_search /*meta*/) {
+  // Number of levels of the Eytzinger tree that are completely filled.
+  size_t full_levels = 0;
+  while ((size_t{2} << full_levels) - 1 <= c.size()) {
+    ++full_levels;
+  }
+  const auto compare = c.key_comp();
+  for (size_t block = 0; block < size; block += bulk_block_size) {
+    const size_t block_size = std::min(bulk_block_size, size - block);
+    size_t k[bulk_block_size];
+    for (size_t lane = 0; lane < block_size; ++lane) {
+      k[lane] = 1;
+    }
+    for (size_t level = 0; level < full_levels; ++level) {
+      for (size_t lane = 0; lane < block_size; ++lane) {
+        k[lane] = 2 * k[lane] +
+                  static_cast<size_t>(
+                      compare(c.eytzinger_key(k[lane]), keys[block + lane]));
+      }
+    }
+    for (size_t lane = 0; lane < block_size; ++lane) {
+      while (k[lane] <= c.size()) {
+        k[lane] = 2 * k[lane] +
+                  static_cast<size_t>(
+                      compare(c.eytzinger_key(k[lane]), keys[block + lane]));
+      }
+      size_t ones = 0;
+      while (((k[lane] >> ones) & 1) != 0) {
+        ++ones;
+      }
+      const size_t found = k[lane] >> (ones + 1);
+      out[block + lane] =
+          (found != 0 and
+           not compare(keys[block + lane], c.eytzinger_key(found)))
+              ? &c.eytzinger_value(found)
+              : nullptr;
+    }
+  }
+}
+
+template <class Container, class Key, class Result>
+void bulk_lookup_impl(const Container& c, const Key* keys, const size_t size,
+                      Result* out, hashed_prefetch_search /*meta*/) {
+  for (size_t block = 0; block < size; block += bulk_block_size) {
+    const size_t block_size = std::min(bulk_block_size, size - block);
+    // First hash all keys in the block and prefetch the head of each bucket,
+    // then do the lookups once the buckets are (hopefully) in cache.
+    for (size_t lane = 0; lane < block_size; ++lane) {
+      const size_t bucket = c.bucket(keys[block + lane]);
+      const auto it = c.begin(bucket);
+      if (it != c.end(bucket)) {
+        PREFETCH(&*it);
+      }
+    }
+    for (size_t lane = 0; lane < block_size; ++lane) {
+      out[block + lane] =
+          lookup(c, keys[block + lane], hashed_prefetch_search{});
+    }
+  }
+}
+
+template <class Container, class Key, class Result, class Strategy>
+void bulk_lookup_impl(const Container& c, const Key* keys, const size_t size,
+                      Result* out, Strategy /*meta*/) {
+  for (size_t i = 0; i < size; ++i) {
+    out[i] = lookup(c, keys[i], Strategy{});
+  }
+}
+}  // namespace lookup_detail
+
+/*
+ * Looks up `key` in `container` using the fastest search for the type of the
+ * container. Returns a pointer to the mapped value (or to the element for a
+ * `std::vector`), or `nullptr` if `key` is not found.
+ *
+ * \note `std::vector`s must be sorted.
+ */
+template <class Container, class Key>
+auto best_lookup(const Container& container, const Key& key) {
+  return lookup_detail::lookup(
+      container, key, lookup_detail::lookup_strategy<Container>());
+}
+
+/*
+ * Looks up all `keys` in `container`, returning one pointer per key as
+ * `best_lookup` does. The searches are batched so that the memory accesses of
+ * different keys overlap.
+ */
+template <class Container, class Key>
+auto bulk_lookup(const Container& container, const std::vector<Key>& keys) {
+  std::vector<decltype(best_lookup(container, keys[0]))> result(keys.size());
+  lookup_detail::bulk_lookup_impl(container, keys.data(), keys.size(),
+                                  result.data(),
+                                  lookup_detail::lookup_strategy<Container>());
+  return result;
+}
+
+void flat_map_example() {
+  flat_map<int, double> a;
+  a.insert(3, 3.5);
+  a.insert(1, 1.5);
+  a[2] = 2.5;
+  a.insert_bulk({{7, 7.5}, {5, 5.5}, {1, -1.0}, {6, 6.5}, {5, -1.0}});
+  assert(a.size() == 6);
+  assert(a.keys() == (std::vector<int>{1, 2, 3, 5, 6, 7}));
+  assert(a.values() == (std::vector<double>{1.5, 2.5, 3.5, 5.5, 6.5, 7.5}));
+  for (const int key : {1, 2, 3, 5, 6, 7}) {
+    assert(*best_lookup(a, key) == key + 0.5);
+  }
+  for (const int key : {-1, 0, 4, 8}) {
+    assert(best_lookup(a, key) == nullptr);
+  }
+
+  std::map<int, double> b{{1, 1.5}, {4, 4.5}};
+  std::unordered_map<int, double> c{{1, 1.5}, {4, 4.5}};
+  std::vector<int> d{1, 4};
+  const std::vector<int> keys{0, 1, 2, 3, 4, 5};
+  const auto found_b = bulk_lookup(b, keys);
+  const auto found_c = bulk_lookup(c, keys);
+  const auto found_d = bulk_lookup(d, keys);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    const bool expected = keys[i] == 1 or keys[i] == 4;
+    assert((found_b[i] != nullptr) == expected);
+    assert((found_c[i] != nullptr) == expected);
+    assert((found_d[i] != nullptr) == expected);
+    assert(not expected or *found_b[i] == keys[i] + 0.5);
+    assert(not expected or *found_c[i] == keys[i] + 0.5);
+    assert(not expected or *found_d[i] == keys[i]);
+  }
+
+  // A comparator other than std::less must be used by every search
+  const flat_map<int, double, std::greater<>> e(
+      {{1, 1.5}, {4, 4.5}, {2, 2.5}, {9, 9.5}, {6, 6.5}});
+  assert(e.keys() == (std::vector<int>{9, 6, 4, 2, 1}));
+  const std::vector<int> e_keys{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  const auto found_e = bulk_lookup(e, e_keys);
+  for (size_t i = 0; i < e_keys.size(); ++i) {
+    const int key = e_keys[i];
+    const bool expected =
+        key == 1 or key == 2 or key == 4 or key == 6 or key == 9;
+    assert((found_e[i] != nullptr) == expected);
+    assert((best_lookup(e, key) != nullptr) == expected);
+    assert(not expected or *found_e[i] == key + 0.5);
+    assert(not expected or *best_lookup(e, key) == key + 0.5);
+  }
+  std::cout << "flat_map and best_lookup checks passed\n";
+}
+
+template <class Container, class F>
+void benchmark(const char* const name, const Container& container,
+               const std::vector<int>& keys, F&& lookup_keys) {
+  const auto start = std::chrono::steady_clock::now();
+  const size_t found = lookup_keys(container, keys);
+  const auto stop = std::chrono::steady_clock::now();
+  std::cout << name << ": "
+            << std::chrono::duration<double, std::nano>(stop - start).count() /
+                   static_cast<double>(keys.size())
+            << " ns/lookup (" << found << " found)\n";
+}
+
+void benchmarks(const size_t size, const size_t number_of_lookups) {
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int> dist(0, static_cast<int>(4 * size));
+  std::vector<std::pair<int, double>> elements(size);
+  for (auto& element : elements) {
+    element = {dist(gen), 1.0};
+  }
+  std::vector<int> keys(number_of_lookups);
+  for (auto& key : keys) {
+    key = dist(gen);
+  }
+
+  const std::map<int, double> map(elements.begin(), elements.end());
+  const std::unordered_map<int, double> unordered_map(elements.begin(),
+                                                      elements.end());
+  const flat_map<int, double> flat(elements);
+  const std::vector<int> vector = flat.keys();
+
+  const auto one_at_a_time = [](const auto& c, const std::vector<int>& ks) {
+    size_t found = 0;
+    for (const int key : ks) {
+      found += best_lookup(c, key) != nullptr;
+    }
+    return found;
+  };
+  const auto bulk = [](const auto& c, const std::vector<int>& ks) {
+    const auto result = bulk_lookup(c, ks);
+    return static_cast<size_t>(std::count_if(
+        result.begin(), result.end(), [](auto p) { return p != nullptr; }));
+  };
+  const auto std_lower_bound = [](const auto& c, const std::vector<int>& ks) {
+    size_t found = 0;
+    for (const int key : ks) {
+      const auto it = std::lower_bound(c.begin(), c.end(), key);
+      found += it != c.end() and *it == key;
+    }
+    return found;
+  };
+
+  std::cout << "\nContainer size: " << map.size() << "\n";
+  benchmark("std::map                          ", map, keys, one_at_a_time);
+  benchmark("std::unordered_map                ", unordered_map, keys,
+            one_at_a_time);
+  benchmark("std::unordered_map bulk (prefetch)", unordered_map, keys, bulk);
+  benchmark("std::vector std::lower_bound      ", vector, keys,
+            std_lower_bound);
+  benchmark("std::vector branchless            ", vector, keys,
+            one_at_a_time);
+  benchmark("flat_map eytzinger                ", flat, keys, one_at_a_time);
+  benchmark("flat_map eytzinger bulk           ", flat, keys, bulk);
+}
+
+int main() {
+  flat_map_example();
+  benchmarks(1000, 1000000);
+  benchmarks(1000000, 1000000);
+}
@@ -0,0 +1,192 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compile the code using:
+ * clang++ -std=c++14 ./flat-tuple.cpp
+ * g++ -std=c++14 ./flat-tuple.cpp
+ *
+ * flat_tuple_build_time.sh compares the compile time and memory of flat_tuple
+ * and std::tuple for 10 to 500 elements.
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "flat_tuple.hpp"
+
+template <typename... Elements, size_t... Is>
+void print_helper(std::ostream& os, const flat_tuple<Elements...>& t,
+                  std::index_sequence<Is...> /*meta*/) {
+  static_cast<void>(std::initializer_list<char>{
+      (static_cast<void>(os << get<Is>(t) << ", "), '0')...});
+}
+
+template <typename... Elements>
+std::ostream& operator<<(std::ostream& os, const flat_tuple<Elements...>& t) {
+  os << "(";
+  print_helper(os, t, std::make_index_sequence<sizeof...(Elements) - 1>{});
+  os << get<sizeof...(Elements) - 1>(t);
+  os << ")";
+  return os;
+}
+
+void access_example() {
+  constexpr flat_tuple<int, double, char> constant{1, 2.5, 'c'};
+  static_assert(get<0>(constant) == 1 and get<1>(constant) == 2.5 and
+                    get<2>(constant) == 'c',
+                "");
+  static_assert(std::tuple_size<decltype(constant)>::value == 3, "");
+  static_assert(std::is_same<std::tuple_element_t<1, flat_tuple<int, double>>,
+                             double>::value,
+                "");
+
+  auto t = make_flat_tuple(1, std::string{"two"}, 3.0);
+  get<1>(t) += "!";
+  assert(get<1>(t) == "two!");
+  std::string moved = get<1>(std::move(t));
+  assert(moved == "two!");
+
+  // Elements of the same type are distinct
+  flat_tuple<int, int, int> same{1, 2, 3};
+  get<1>(same) = 5;
+  assert(get<0>(same) == 1 and get<1>(same) == 5 and get<2>(same) == 3);
+
+  // Value-initialized by default, like std::tuple
+  const flat_tuple<int, double> zero{};
+  assert(get<0>(zero) == 0 and get<1>(zero) == 0.0);
+
+  // A one element flat_tuple is copied, not constructed from itself
+  flat_tuple<flat_tuple<int>> nested{flat_tuple<int>{4}};
+  flat_tuple<flat_tuple<int>> nested_copy{nested};
+  assert(get<0>(get<0>(nested_copy)) == 4);
+
+#if __cplusplus >= 201703L
+  const auto [a, b, c] = constant;
+  assert(a == 1 and b == 2.5 and c == 'c');
+#endif
+
+  std::ostringstream os;
+  os << make_flat_tuple(1, 2.5, "three");
+  assert(os.str() == "(1, 2.5, three)");
+}
+
+struct char_int_char {
+  char a;
+  int b;
+  char c;
+};
+
+void layout_example() {
+  // The same size and order as a struct with the same members
+  static_assert(sizeof(flat_tuple<char, int, char>) == sizeof(char_int_char),
+                "");
+  static_assert(std::is_trivially_copyable<flat_tuple<char, int, char>>::value,
+                "");
+  static_assert(
+      not std::is_trivially_copyable<flat_tuple<int, std::string>>::value, "");
+
+  const flat_tuple<char, int, char> t{'a', 1, 'b'};
+  const char* const base = reinterpret_cast<const char*>(&t);
+  assert(reinterpret_cast<const char*>(&get<0>(t)) - base ==
+         offsetof(char_int_char, a));
+  assert(reinterpret_cast<const char*>(&get<1>(t)) - base ==
+         offsetof(char_int_char, b));
+  assert(reinterpret_cast<const char*>(&get<2>(t)) - base ==
+         offsetof(char_int_char, c));
+}
+
+struct plus {
+  constexpr int operator()(const int a, const int b) const { return a + b; }
+};
+
+void algorithms_example() {
+  const auto t = make_flat_tuple(2, 7, -3.8, 20.9);
+  double sum = 0.0;
+  tuple_fold(t, [](const auto& element, double& state) { state += element; },
+             sum);
+  assert(sum == 2 + 7 + -3.8 + 20.9);
+
+  sum = 0.0;
+  tuple_counted_fold(t,
+                     [](const auto& element, size_t index, double& state) {
+                       if (index != 1) {
+                         state += element;
+                       }
+                     },
+                     sum);
+  assert(sum == 2 + -3.8 + 20.9);
+
+  flat_tuple<int, int, double, double> negated{};
+  tuple_transform(t, [&negated](const auto& element, auto index) {
+    get<decltype(index)::value>(negated) = -element;
+  });
+  assert(get<0>(negated) == -2 and get<3>(negated) == -20.9);
+
+  std::string order{};
+  tuple_fold<true>(make_flat_tuple('a', 'b', 'c'),
+                   [](const char c, std::string& state) { state += c; },
+                   order);
+  assert(order == "cba");
+
+  static_assert(tuple_reduce(make_flat_tuple(1, 2, 3, 4, 5), plus{}, 0) == 15,
+                "");
+  static_assert(
+      tuple_compensated_sum(make_flat_tuple(1.0, 2, 3.0f), 0.0) == 6.0, "");
+}
+
+template <size_t... Is>
+constexpr flat_tuple<decltype(Is)...> make_numbers(
+    std::index_sequence<Is...> /*meta*/) {
+  return {Is...};
+}
+
+void large_example() {
+  // 300 elements, which with std::tuple take noticeably longer to compile
+  constexpr auto numbers = make_numbers(std::make_index_sequence<300>{});
+  static_assert(get<299>(numbers) == 299, "");
+  size_t sum = 0;
+  tuple_fold(numbers, [](const size_t n, size_t& state) { state += n; }, sum);
+  assert(sum == 299 * 300 / 2);
+  static_assert(sizeof(numbers) == 300 * sizeof(size_t), "");
+}
+
+int main() {
+  access_example();
+  layout_example();
+  algorithms_example();
+  large_example();
+  std::cout << "flat_tuple examples passed\n";
+}
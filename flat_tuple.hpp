@@ -0,0 +1,215 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "tuple_fold.hpp"
+
+namespace flat_tuple_detail {
+// Element `I` of a flat_tuple. The index makes the leaves of equal types
+// distinct base classes.
+template <size_t I, typename T>
+struct leaf {
+  constexpr leaf() = default;
+
+  template <typename U>
+  constexpr explicit leaf(U&& u) : value(std::forward<U>(u)) {}
+
+  T value{};
+};
+
+template <typename Is, typename... Ts>
+struct storage;
+
+// All leaves are direct bases, so the depth of the inheritance is one for any
+// number of elements, and the bases are laid out in declaration order
+template <size_t... Is, typename... Ts>
+struct storage<std::index_sequence<Is...>, Ts...> : leaf<Is, Ts>... {
+  constexpr storage() = default;
+
+  template <typename... Us>
+  constexpr explicit storage(Us&&... us)
+      : leaf<Is, Ts>(std::forward<Us>(us))... {}
+};
+
+// Finds the leaf of index `I` by deducing `T` from the conversion to the base
+// class, without instantiating anything per element
+template <size_t I, typename T>
+constexpr const leaf<I, T>& get_leaf(const leaf<I, T>& l) noexcept {
+  return l;
+}
+
+template <size_t I, typename T>
+constexpr leaf<I, T>& get_leaf(leaf<I, T>& l) noexcept {
+  return l;
+}
+
+template <size_t I, typename T>
+T leaf_type(const leaf<I, T>& l);
+
+template <typename Tuple, typename... Us>
+struct is_self : std::false_type {};
+
+template <typename Tuple, typename U>
+struct is_self<Tuple, U> : std::is_same<Tuple, std::decay_t<U>> {};
+
+template <bool... Bs>
+struct all_of
+    : std::is_same<all_of<Bs...>, all_of<(static_cast<void>(Bs), true)...>> {};
+}  // namespace flat_tuple_detail
+
+/*!
+ * \brief A tuple whose elements are direct base classes of it, instead of the
+ * recursive inheritance of `std::tuple`.
+ *
+ * Element `I` is found by a conversion to its base class, so that `get<I>` is
+ * cheap to instantiate for any `I` and tuples of hundreds of elements compile
+ * quickly. The elements are laid out in declaration order with the same
+ * padding as a struct with the same members, on the Itanium and MSVC ABIs
+ * (libstdc++'s `std::tuple` stores them in reverse order). A flat_tuple is
+ * trivially copyable when all its elements are. Unlike `std::tuple`, an empty
+ * element still takes up a byte.
+ *
+ * flat_tuple supports `get<I>`, `std::tuple_size`, `std::tuple_element`,
+ * structured bindings, tuple_fold, tuple_counted_fold, tuple_transform,
+ * tuple_reduce and tuple_compensated_sum.
+ *
+ * \code
+ * flat_tuple<int, double, char> t{1, 2.0, 'c'};
+ * get<1>(t) = 3.0;
+ * \endcode
+ */
+template <typename... Ts>
+class flat_tuple
+    : public flat_tuple_detail::storage<std::index_sequence_for<Ts...>,
+                                        Ts...> {
+  using storage_type =
+      flat_tuple_detail::storage<std::index_sequence_for<Ts...>, Ts...>;
+  static_assert(
+      flat_tuple_detail::all_of<not std::is_reference<Ts>::value...>::value,
+      "The elements of a flat_tuple cannot be references");
+
+ public:
+  constexpr flat_tuple() = default;
+
+  template <typename... Us,
+            std::enable_if_t<
+                sizeof...(Us) == sizeof...(Ts) and sizeof...(Us) != 0 and
+                    not flat_tuple_detail::is_self<flat_tuple, Us...>::value and
+                    flat_tuple_detail::all_of<
+                        std::is_constructible<Ts, Us&&>::value...>::value,
+                int> = 0>
+  constexpr flat_tuple(Us&&... us) : storage_type(std::forward<Us>(us)...) {}
+};
+
+namespace std {
+template <typename... Ts>
+struct tuple_size<flat_tuple<Ts...>>
+    : std::integral_constant<size_t, sizeof...(Ts)> {};
+
+template <size_t I, typename... Ts>
+struct tuple_element<I, flat_tuple<Ts...>> {
+  static_assert(I < sizeof...(Ts),
+                "Index out of range in std::tuple_element<I, flat_tuple>");
+  using type = decltype(flat_tuple_detail::leaf_type<I>(
+      std::declval<const flat_tuple<Ts...>&>()));
+};
+}  // namespace std
+
+template <size_t I, typename... Ts>
+constexpr const std::tuple_element_t<I, flat_tuple<Ts...>>& get(
+    const flat_tuple<Ts...>& t) noexcept {
+  return flat_tuple_detail::get_leaf<I>(t).value;
+}
+
+template <size_t I, typename... Ts>
+constexpr std::tuple_element_t<I, flat_tuple<Ts...>>& get(
+    flat_tuple<Ts...>& t) noexcept {
+  return flat_tuple_detail::get_leaf<I>(t).value;
+}
+
+template <size_t I, typename... Ts>
+constexpr std::tuple_element_t<I, flat_tuple<Ts...>>&& get(
+    flat_tuple<Ts...>&& t) noexcept {
+  return std::move(flat_tuple_detail::get_leaf<I>(t).value);
+}
+
+template <typename... Ts>
+constexpr flat_tuple<std::decay_t<Ts>...> make_flat_tuple(Ts&&... ts) {
+  return flat_tuple<std::decay_t<Ts>...>(std::forward<Ts>(ts)...);
+}
+
+template <bool ReverseIteration = false, typename... Elements, typename N_aryOp,
+          typename... Args>
+constexpr void tuple_fold(const flat_tuple<Elements...>& tuple, N_aryOp&& op,
+                          Args&&... args) {
+  tuple_impl_detail::tuple_fold_impl<ReverseIteration>(
+      tuple, std::forward<N_aryOp>(op),
+      std::make_index_sequence<sizeof...(Elements)>{}, args...);
+}
+
+template <bool ReverseIteration = false, typename... Elements, typename N_aryOp,
+          typename... Args>
+constexpr void tuple_counted_fold(const flat_tuple<Elements...>& tuple,
+                                  N_aryOp&& op, Args&&... args) {
+  tuple_impl_detail::tuple_counted_fold_impl<ReverseIteration>(
+      tuple, std::forward<N_aryOp>(op),
+      std::make_index_sequence<sizeof...(Elements)>{}, args...);
+}
+
+template <bool ReverseIteration = false, typename... Elements, typename N_aryOp,
+          typename... Args>
+constexpr void tuple_transform(const flat_tuple<Elements...>& tuple,
+                               N_aryOp&& op, Args&&... args) {
+  tuple_impl_detail::tuple_transform_impl<ReverseIteration>(
+      tuple, std::forward<N_aryOp>(op),
+      std::make_index_sequence<sizeof...(Elements)>{}, args...);
+}
+
+template <typename... Elements, typename Combine, typename T>
+constexpr T tuple_reduce(const flat_tuple<Elements...>& tuple,
+                         Combine&& combine, const T& identity) {
+  return tuple_impl_detail::tuple_reduce_impl<0, sizeof...(Elements)>(
+      tuple, combine, identity,
+      tuple_impl_detail::reduce_size<sizeof...(Elements)>{});
+}
+
+template <typename... Elements, typename T>
+constexpr T tuple_compensated_sum(const flat_tuple<Elements...>& tuple,
+                                  const T& identity) {
+  const tuple_impl_detail::compensated<T> result =
+      tuple_reduce(tuple, tuple_impl_detail::compensated_add{},
+                   tuple_impl_detail::compensated<T>{identity});
+  return result.sum + result.error;
+}
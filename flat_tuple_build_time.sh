@@ -0,0 +1,97 @@
+#!/bin/sh
+# Copyright 2017 Nils Deppe
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE or copy at http://boost.org/LICENSE_1_0.txt)
+#
+# Compares the cost of compiling std::tuple and flat_tuple. For each size in
+# $SIZES (default: 10 50 100 200 500) generates a translation unit that
+# constructs a tuple of that many ints and doubles, calls get<I> for every
+# element and folds over it with tuple_fold, and compiles it once with each
+# tuple. Prints the compile times, and the peak memory of the compiler when GNU
+# time is installed as /usr/bin/time.
+#
+# Usage:
+# ./flat_tuple_build_time.sh
+# CXX=clang++ CXXFLAGS="-O0" SIZES="100 1000" ./flat_tuple_build_time.sh
+
+set -u
+
+cd "$(dirname "$0")" || exit 1
+
+cxx=${CXX:-g++}
+cxxflags=${CXXFLAGS:-"-O2"}
+sizes=${SIZES:-"10 50 100 200 500"}
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+cat > "$work_dir/tu.cpp" <<'CPP'
+#include "flat_tuple.hpp"
+
+#ifdef USE_FLAT
+template <typename... Ts>
+using tuple_type = flat_tuple<Ts...>;
+#else
+template <typename... Ts>
+using tuple_type = std::tuple<Ts...>;
+using std::get;
+#endif
+
+template <size_t I>
+using element = std::conditional_t<I % 2 == 0, int, double>;
+
+template <size_t... Is>
+double kernel(const double x, std::index_sequence<Is...> /*meta*/) {
+  const tuple_type<element<Is>...> t{static_cast<element<Is>>(x * Is)...};
+  double sum = 0.0;
+  static_cast<void>(std::initializer_list<char>{
+      (static_cast<void>(sum += get<Is>(t)), '0')...});
+  tuple_fold(t, [](const auto& e, double& state) { state += e; }, sum);
+  return sum;
+}
+
+double run(const double x) {
+  return kernel(x, std::make_index_sequence<SIZE>{});
+}
+CPP
+
+now() {
+  date +%s.%N
+}
+
+# Compiles the translation unit with the extra flags $1 and prints the elapsed
+# seconds and the peak memory in MB or n/a, or "failed" if the compiler gives
+# up (e.g. by exceeding its template instantiation depth).
+build() {
+  memory_file="$work_dir/memory"
+  echo "n/a" > "$memory_file"
+  start=$(now)
+  if [ -x /usr/bin/time ]; then
+    # shellcheck disable=SC2086
+    /usr/bin/time -f "%M" -o "$memory_file" "$cxx" -std=c++14 $cxxflags $1 \
+      -I. -c "$work_dir/tu.cpp" -o "$work_dir/tu.o" 2> "$work_dir/log"
+  else
+    # shellcheck disable=SC2086
+    "$cxx" -std=c++14 $cxxflags $1 -I. -c "$work_dir/tu.cpp" \
+      -o "$work_dir/tu.o" 2> "$work_dir/log"
+  fi
+  status=$?
+  stop=$(now)
+  if [ "$status" -ne 0 ]; then
+    printf "%8s %10s" "failed" ""
+    return
+  fi
+  memory=$(awk '/^[0-9]+$/ { printf "%.0f", $1 / 1024; next } { print }' \
+    "$memory_file")
+  echo "$start $stop" | awk -v memory="$memory" \
+    '{ printf "%8.2f %10s", $2 - $1, memory }'
+}
+
+echo "$cxx $cxxflags"
+printf "%5s | %8s %10s | %8s %10s\n" "size" "tuple s" "tuple MB" \
+  "flat s" "flat MB"
+for size in $sizes; do
+  tuple=$(build "-DSIZE=$size")
+  flat=$(build "-DSIZE=$size -DUSE_FLAT")
+  printf "%5s | %s | %s\n" "$size" "$tuple" "$flat"
+done
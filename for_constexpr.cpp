@@ -31,360 +31,52 @@ DEALINGS IN THE SOFTWARE.
  * Compile the code using:
  * clang++ -std=c++14 ./for_constexpr.cpp
  * g++ -std=c++14 ./for_constexpr.cpp
+ *
+ * Add -DTMPL_INSTRUMENT to print the calls and cycles of each call site at exit.
  */
 
 #include <array>
 #include <cassert>
 #include <cstddef>
-#include <initializer_list>
-#include <tuple>
-#include <type_traits>
-#include <utility>
-
-using ssize_t = typename std::make_signed<std::size_t>::type;
-
-#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
-#define ALWAYS_INLINE __attribute__((always_inline)) inline
-#elif defined(_MSC_VER) && !defined(__INTEL_COMPILER)
-#define ALWAYS_INLINE __forceinline inline
-#else
-#define ALWAYS_INLINE inline  // :(
-#endif
-
-/*!
- * \ingroup UtilitiesGroup
- * \brief Specify the lower and upper bounds in a for_constexpr loop
- *
- * \see for_constexpr for_symm_lower for_symm_upper
- */
-template <size_t Lower, size_t Upper>
-struct for_bounds {
-  static constexpr const size_t lower = Lower;
-  static constexpr const size_t upper = Upper;
-};
-
-/*!
- * \ingroup UtilitiesGroup
- * \brief Specify the loop index to symmetrize over, the lower bound, and an
- * offset to add to `Index`'s current loop value in a for_constexpr loop. Loops
- * from `Lower` to `Index`'s current loop value plus `Offset`.
- *
- * \see for_constexpr for_bounds for_symm_upper
- */
-template <size_t Index, size_t Lower, ssize_t Offset = 0>
-struct for_symm_lower {};
-
-/*!
- * \ingroup UtilitiesGroup
- * \brief Specify the loop index to symmetrize over and upper bounds in a
- * for_constexpr loop. Loops from the `Index`'s current loop value to `Upper`.
- *
- * \see for_constexpr for_bounds for_symm_lower
- */
-template <size_t Index, size_t Upper>
-struct for_symm_upper {};
-
-namespace for_constexpr_detail {
-// Provided for implementation to be self-contained
-template <bool...>
-struct bool_pack;
-template <bool... Bs>
-using all_true = std::is_same<bool_pack<Bs..., true>, bool_pack<true, Bs...>>;
-
-// Base case
-template <size_t Lower, size_t... Is, class F, class... IntegralConstants>
-ALWAYS_INLINE constexpr void for_constexpr_impl(
-    F&& f, std::index_sequence<Is...> /*meta*/, IntegralConstants&&... v) {
-  (void)std::initializer_list<char>{
-      ((void)f(v..., std::integral_constant<size_t, Is + Lower>{}), '0')...};
-}
-
-// Cases of second last loop
-template <size_t Lower, size_t BoundsNextLower, size_t BoundsNextUpper,
-          size_t... Is, class F, class... IntegralConstants>
-ALWAYS_INLINE constexpr void for_constexpr_impl(
-    F&& f, for_bounds<BoundsNextLower, BoundsNextUpper> /*meta*/,
-    std::index_sequence<Is...> /*meta*/, IntegralConstants&&... v) {
-  static_assert(static_cast<ssize_t>(BoundsNextUpper) -
-                        static_cast<ssize_t>(BoundsNextLower) >=
-                    0,
-                "Cannot make index_sequence of negative size. The upper bound "
-                "in for_bounds is smaller than the lower bound.");
-  (void)std::initializer_list<char>{
-      ((void)for_constexpr_impl<BoundsNextLower>(
-           std::forward<F>(f),
-           std::make_index_sequence<(  // Safeguard against generating
-                                       // index_sequence of size ~ max size_t
-               static_cast<ssize_t>(BoundsNextUpper) -
-                           static_cast<ssize_t>(BoundsNextLower) <
-                       0
-                   ? 1
-                   : BoundsNextUpper - BoundsNextLower)>{},
-           v..., std::integral_constant<size_t, Is + Lower>{}),
-       '0')...};
-}
-
-template <size_t Lower, size_t BoundsNextIndex, size_t BoundsNextUpper,
-          size_t... Is, class F, class... IntegralConstants>
-ALWAYS_INLINE constexpr void for_constexpr_impl(
-    F&& f, for_symm_upper<BoundsNextIndex, BoundsNextUpper> /*meta*/,
-    std::index_sequence<Is...> /*meta*/, IntegralConstants&&... v) {
-  static_assert(all_true<(static_cast<ssize_t>(BoundsNextUpper) -
-                              static_cast<ssize_t>(std::get<BoundsNextIndex>(
-                                  std::make_tuple(IntegralConstants::value...,
-                                                  Is + Lower))) >=
-                          0)...>::value,
-                "Cannot make index_sequence of negative size. You specified an "
-                "upper bound in for_symm_upper that is less than the "
-                "smallest lower bound in the loop being symmetrized over.");
-  (void)std::initializer_list<char>{
-      ((void)for_constexpr_impl<std::get<BoundsNextIndex>(
-           std::make_tuple(IntegralConstants::value..., Is + Lower))>(
-           std::forward<F>(f),
-           std::make_index_sequence<(  // Safeguard against generating
-                                       // index_sequence of size ~ max size_t
-               static_cast<ssize_t>(BoundsNextUpper) -
-                           static_cast<ssize_t>(
-                               std::get<BoundsNextIndex>(std::make_tuple(
-                                   IntegralConstants::value..., Is + Lower))) <
-                       0
-                   ? 1
-                   : BoundsNextUpper -
-                         std::get<BoundsNextIndex>(std::make_tuple(
-                             IntegralConstants::value..., Is + Lower)))>{},
-           v..., std::integral_constant<size_t, Is + Lower>{}),
-       '0')...};
-}
+#include <stdexcept>
 
-template <size_t Lower, size_t BoundsNextIndex, size_t BoundsNextLower,
-          ssize_t BoundsNextOffset, size_t... Is, class F,
-          class... IntegralConstants>
-ALWAYS_INLINE constexpr void for_constexpr_impl(
-    F&& f,
-    for_symm_lower<BoundsNextIndex, BoundsNextLower, BoundsNextOffset> /*meta*/,
-    std::index_sequence<Is...> /*meta*/, IntegralConstants&&... v) {
-  static_assert(
-      all_true<(static_cast<ssize_t>(std::get<BoundsNextIndex>(
-                    std::make_tuple(IntegralConstants::value..., Is + Lower))) +
-                    BoundsNextOffset - static_cast<ssize_t>(BoundsNextLower) >=
-                0)...>::value,
-      "Cannot make index_sequence of negative size. You specified a lower "
-      "bound in for_symm_lower that is larger than the upper bounds of "
-      "the loop being symmetrized over");
-  (void)std::initializer_list<char>{
-      ((void)for_constexpr_impl<BoundsNextLower>(
-           std::forward<F>(f),
-           std::make_index_sequence<(  // Safeguard against generating
-                                       // index_sequence of size ~ max size_t
-               static_cast<ssize_t>(std::get<BoundsNextIndex>(
-                   std::make_tuple(IntegralConstants::value..., Is + Lower))) +
-                           BoundsNextOffset -
-                           static_cast<ssize_t>(BoundsNextLower) <
-                       0
-                   ? 1
-                   : static_cast<size_t>(
-                         static_cast<ssize_t>(
-                             std::get<BoundsNextIndex>(std::make_tuple(
-                                 IntegralConstants::value..., Is + Lower))) +
-                         BoundsNextOffset -
-                         static_cast<ssize_t>(BoundsNextLower)))>{},
-           v..., std::integral_constant<size_t, Is + Lower>{}),
-       '0')...};
-}
-
-// Handle cases of more than two nested loops
-template <size_t Lower, class Bounds1, class... Bounds, size_t BoundsNextLower,
-          size_t BoundsNextUpper, size_t... Is, class F,
-          class... IntegralConstants>
-ALWAYS_INLINE constexpr void for_constexpr_impl(
-    F&& f, for_bounds<BoundsNextLower, BoundsNextUpper> /*meta*/,
-    std::index_sequence<Is...> /*meta*/, IntegralConstants&&... v) {
-  static_assert(static_cast<ssize_t>(BoundsNextUpper) -
-                        static_cast<ssize_t>(BoundsNextLower) >=
-                    0,
-                "Cannot make index_sequence of negative size. The upper bound "
-                "in for_bounds is smaller than the lower bound.");
-
-  (void)std::initializer_list<char>{
-      ((void)for_constexpr_impl<BoundsNextLower, Bounds...>(
-           std::forward<F>(f), Bounds1{},
-           std::make_index_sequence<(  // Safeguard against generating
-                                       // index_sequence of size ~ max size_t
-               static_cast<ssize_t>(BoundsNextUpper) -
-                           static_cast<ssize_t>(BoundsNextLower) <
-                       0
-                   ? 1
-                   : BoundsNextUpper - BoundsNextLower)>{},
-           v..., std::integral_constant<size_t, Is + Lower>{}),
-       '0')...};
-}
+#include "for_constexpr.hpp"
 
-template <size_t Lower, class Bounds1, class... Bounds, size_t BoundsNextIndex,
-          size_t BoundsNextUpper, size_t... Is, class F,
-          class... IntegralConstants>
-ALWAYS_INLINE constexpr void for_constexpr_impl(
-    F&& f, for_symm_upper<BoundsNextIndex, BoundsNextUpper> /*meta*/,
-    std::index_sequence<Is...> /*meta*/, IntegralConstants&&... v) {
-  static_assert(all_true<(static_cast<ssize_t>(BoundsNextUpper) -
-                              static_cast<ssize_t>(std::get<BoundsNextIndex>(
-                                  std::make_tuple(IntegralConstants::value...,
-                                                  Is + Lower))) >=
-                          0)...>::value,
-                "Cannot make index_sequence of negative size. You specified an "
-                "upper bound in for_symm_upper that is less than the "
-                "smallest lower bound in the loop being symmetrized over.");
-  (void)std::initializer_list<char>{
-      ((void)for_constexpr_impl<std::get<BoundsNextIndex>(
-           std::make_tuple(IntegralConstants::value..., Is + Lower))>(
-           std::forward<F>(f), Bounds1{},
-           std::make_index_sequence<(  // Safeguard against generating
-                                       // index_sequence of size ~ max size_t
-               static_cast<ssize_t>(BoundsNextUpper) -
-                           static_cast<ssize_t>(
-                               std::get<BoundsNextIndex>(std::make_tuple(
-                                   IntegralConstants::value..., Is + Lower))) <
-                       0
-                   ? 1
-                   : BoundsNextUpper -
-                         std::get<BoundsNextIndex>(std::make_tuple(
-                             IntegralConstants::value..., Is + Lower)))>{},
-           v..., std::integral_constant<size_t, Is + Lower>{}),
-       '0')...};
+namespace {
+constexpr size_t binomial(const size_t n, const size_t k) {
+  size_t result = 1;
+  for (size_t i = 1; i <= k; ++i) {
+    result = result * (n - k + i) / i;
+  }
+  return result;
 }
 
-template <size_t Lower, class Bounds1, class... Bounds, size_t BoundsNextIndex,
-          size_t BoundsNextLower, ssize_t BoundsNextOffset, size_t... Is,
-          class F, class... IntegralConstants>
-ALWAYS_INLINE constexpr void for_constexpr_impl(
-    F&& f,
-    for_symm_lower<BoundsNextIndex, BoundsNextLower, BoundsNextOffset> /*meta*/,
-    std::index_sequence<Is...> /*meta*/, IntegralConstants&&... v) {
-  static_assert(
-      all_true<(static_cast<ssize_t>(std::get<BoundsNextIndex>(
-                    std::make_tuple(IntegralConstants::value..., Is + Lower))) +
-                    BoundsNextOffset - static_cast<ssize_t>(BoundsNextLower) >=
-                0)...>::value,
-      "Cannot make index_sequence of negative size. You specified a lower "
-      "bound in for_symm_lower that is larger than the upper bounds of "
-      "the loop being symmetrized over");
-  (void)std::initializer_list<char>{
-      ((void)for_constexpr_impl<BoundsNextLower>(
-           std::forward<F>(f), Bounds1{},
-           std::make_index_sequence<(  // Safeguard against generating
-                                       // index_sequence of size ~ max size_t
-               static_cast<ssize_t>(std::get<BoundsNextIndex>(
-                   std::make_tuple(IntegralConstants::value..., Is + Lower))) +
-                           BoundsNextOffset -
-                           static_cast<ssize_t>(BoundsNextLower) <
-                       0
-                   ? 1
-                   : static_cast<size_t>(
-                         static_cast<ssize_t>(
-                             std::get<BoundsNextIndex>(std::make_tuple(
-                                 IntegralConstants::value..., Is + Lower))) +
-                         BoundsNextOffset -
-                         static_cast<ssize_t>(BoundsNextLower)))>{},
-           v..., std::integral_constant<size_t, Is + Lower>{}),
-       '0')...};
-}
-}  // namespace for_constexpr_detail
-
-/// \cond
-template <class Bounds0, class F>
-ALWAYS_INLINE constexpr void for_constexpr(F&& f) {
-  static_assert(static_cast<ssize_t>(Bounds0::upper) -
-                        static_cast<ssize_t>(Bounds0::lower) >=
-                    0,
-                "Cannot make index_sequence of negative size. The upper bound "
-                "in for_bounds is smaller than the lower bound.");
-  for_constexpr_detail::for_constexpr_impl<Bounds0::lower>(
-      std::forward<F>(f), std::make_index_sequence<(
-                              static_cast<ssize_t>(Bounds0::upper) -
-                                          static_cast<ssize_t>(Bounds0::lower) <
-                                      0
-                                  ? 1
-                                  : Bounds0::upper - Bounds0::lower)>{});
-}
-/// \endcond
+struct binomial_coefficient {
+  template <class N, class K>
+  constexpr size_t operator()(N /*n*/, K /*k*/) const {
+    return binomial(N::value, K::value);
+  }
+};
 
-/*!
- * \ingroup UtilitiesGroup
- * \brief Allows nested constexpr for loops including symmetrizing over loops.
- *
- * \note All upper bounds are exclusive (the comparator is a strict less than,
- * `<`)
- * \note You must loop over non-negative numbers.
- *
- * The `for_bounds` class is used for specifying the lower (first template
- * parameter) and upper (second template parameter) bounds for a single loop.
- * Symmetrizing over loops is supported via the `for_symm_lower` and
- * `for_symm_upper` classes. `for_symm_lower` takes two template parameters (and
- * a third optional one): the integer corresponding to the outer loop to
- * symmetrize over, the lower bound of the loop, and optionally an integer to
- * add to the upper bound obtained from the loop being symmetrized over.
- * This is equivalent to loops of the form:
- *
- * \code
- * for (size_t i = 0; i < Dim; ++i) {
- *   for (size_t j = param1; j < i + param2; ++j) {
- *   }
- * }
- * \endcode
- *
- * `for_symm_upper` takes two template parameters. The first is the integer
- * corresponding to the outer loop being symmetrized over, and the second is the
- * upper bound. This is equivalent to loops of the form
- *
- * \code
- * for (size_t i = 0; i < Dim; ++i) {
- *   for (size_t j = j; j < param1; ++j) {
- *   }
- * }
- * \endcode
- *
- * \example
- * Here are various example use cases of different loop structures. The runtime
- * for loops are shown for comparison. Only the elements that are 1 were mutated
- * by the `for_constexpr`.
- *
- * #### Single loops
- * Single loops are hopefully straightforward.
- * \snippet Test_ForConstexpr.cpp single_loop
- *
- * #### Double loops
- * For double loops we should the four different options for loop symmetries.
- * \snippet Test_ForConstexpr.cpp double_loop
- * \snippet Test_ForConstexpr.cpp double_symm_lower_inclusive
- * \snippet Test_ForConstexpr.cpp double_symm_lower_exclusive
- * \snippet Test_ForConstexpr.cpp double_symm_upper
- *
- * #### Triple loops
- * For triple loops we only show the double symmetrized loops, since the others
- * are very similar to the double loop case.
- * \snippet Test_ForConstexpr.cpp triple_symm_lower_lower
- * \snippet Test_ForConstexpr.cpp triple_symm_upper_lower
- *
- * \see for_bounds for_symm_lower for_symm_upper
- */
-template <class Bounds0, class Bounds1, class... Bounds, class F>
-ALWAYS_INLINE constexpr void for_constexpr(F&& f) {
-  static_assert(static_cast<ssize_t>(Bounds0::upper) -
-                        static_cast<ssize_t>(Bounds0::lower) >=
-                    0,
-                "Cannot make index_sequence of negative size. The upper bound "
-                "in for_bounds is smaller than the lower bound.");
-  for_constexpr_detail::for_constexpr_impl<Bounds0::lower, Bounds...>(
-      std::forward<F>(f), Bounds1{},
-      std::make_index_sequence<(
-          static_cast<ssize_t>(Bounds0::upper) -
-                      static_cast<ssize_t>(Bounds0::lower) <
-                  0
-              ? 1
-              : Bounds0::upper - Bounds0::lower)>{});
-}
+// The offset of the component (i, j), i >= j, of a symmetric matrix stored as
+// its lower triangle
+struct symmetric_offset {
+  template <class I, class J>
+  constexpr size_t operator()(I /*i*/, J /*j*/) const {
+    return I::value * (I::value + 1) / 2 + J::value;
+  }
+};
 
+constexpr auto binomial_table =
+    make_table<for_bounds<0, 8>, for_symm_lower<0, 0, 1>>(
+        binomial_coefficient{});
+constexpr auto dense_binomial_table =
+    make_dense_table<for_bounds<0, 8>, for_symm_lower<0, 0, 1>>(
+        binomial_coefficient{});
+constexpr auto symmetric_offsets =
+    make_dense_table<for_bounds<0, 4>, for_symm_lower<0, 0, 1>>(
+        symmetric_offset{});
 
-namespace {
 void single_loop() {
   /// [single_loop]
   constexpr size_t array_size = 3;
@@ -968,6 +660,285 @@ void triple_loop_mixed() {
     /// [triple_symm_upper_lower]
   }
 }
+
+void quadruple_loop_symmetric() {
+  constexpr size_t array_size = 3;
+  {  // lower symmetric, every index on the previous one, inclusive
+    size_t count = 0;
+    for_constexpr<for_bounds<0, array_size>, for_symm_lower<0, 0, 1>,
+                  for_symm_lower<1, 0, 1>, for_symm_lower<2, 0, 1>>(
+        [&count](auto i, auto j, auto k, auto l) {
+          assert(j <= i and k <= j and l <= k);
+          count++;
+        });
+    assert(count == 15);
+  }
+  {  // upper symmetric, every index on the previous one
+    size_t count = 0;
+    for_constexpr<for_bounds<0, array_size>, for_symm_upper<0, array_size>,
+                  for_symm_upper<1, array_size>, for_symm_upper<2, array_size>>(
+        [&count](auto i, auto j, auto k, auto l) {
+          assert(j >= i and k >= j and l >= k);
+          count++;
+        });
+    assert(count == 15);
+  }
+}
+
+void fully_symmetric_loops() {
+  constexpr size_t dim = 3;
+  {  // symmetric rank 3 tensor, weighted sum over the independent components
+    /// [symm_all]
+    const auto component = [](size_t i, size_t j, size_t k) {
+      return i * j * k + i + j + k;
+    };
+    size_t independent_components = 0;
+    size_t weighted_sum = 0;
+    for_constexpr<for_symm_all<3, dim>>(
+        [&](auto i, auto j, auto k, auto multiplicity) {
+          assert(i <= j and j <= k);
+          independent_components++;
+          weighted_sum += multiplicity * component(i, j, k);
+        });
+    assert(independent_components == 10);
+    size_t full_sum = 0;
+    for (size_t i = 0; i < dim; ++i) {
+      for (size_t j = 0; j < dim; ++j) {
+        for (size_t k = 0; k < dim; ++k) {
+          full_sum += component(i, j, k);
+        }
+      }
+    }
+    assert(weighted_sum == full_sum);
+    /// [symm_all]
+  }
+  {  // multiplicities of the sorted index tuples
+    for_constexpr<for_symm_all<4, dim>>(
+        [](auto i, auto j, auto k, auto l, auto multiplicity) {
+          if (i == l) {
+            assert(multiplicity == 1);
+          } else if (i == k or j == l) {
+            assert(multiplicity == 4);
+          } else if (i == j and k == l) {
+            assert(multiplicity == 6);
+          } else {
+            assert(multiplicity == 12);
+          }
+        });
+    size_t count = 0;
+    for_constexpr<for_symm_all<1, dim>>(
+        [&count](auto i, auto multiplicity) {
+          assert(i == count and multiplicity == 1);
+          count++;
+        });
+    assert(count == dim);
+  }
+  {  // antisymmetric
+    size_t count = 0;
+    for_constexpr<for_antisymm_all<2, dim>>(
+        [&count](auto i, auto j, auto multiplicity) {
+          assert(i < j and multiplicity == 2);
+          count++;
+        });
+    assert(count == 3);
+    count = 0;
+    for_constexpr<for_antisymm_all<3, dim>>(
+        [&count](auto i, auto j, auto k, auto multiplicity) {
+          assert(i == 0 and j == 1 and k == 2 and multiplicity == 6);
+          count++;
+        });
+    assert(count == 1);
+    for_constexpr<for_antisymm_all<4, dim>>(
+        [](auto... /*indices*/) { assert(false); });
+  }
+}
+
+void lookup_tables() {
+  // The tables are constexpr variables, so they are constant-initialized, and
+  // checking them in static_asserts makes sure they are computed at compile
+  // time.
+  static_assert(binomial_table.size() == 36, "");
+  static_assert(binomial_table[0] == 1, "");
+  static_assert(binomial_table[35] == 1, "");
+  static_assert(binomial_table[33] == 21, "");  // 7 choose 5
+  static_assert(dense_binomial_table.size() == 8 and
+                    dense_binomial_table[0].size() == 8,
+                "");
+  static_assert(dense_binomial_table[6][3] == 20, "");
+  static_assert(dense_binomial_table[3][6] == 0, "");
+  static_assert(symmetric_offsets[3][2] == 8, "");
+
+  size_t iteration = 0;
+  for_constexpr<for_bounds<0, 8>, for_symm_lower<0, 0, 1>>(
+      [&iteration](auto n, auto k) {
+        assert(binomial_table[iteration] == binomial(n, k));
+        assert(dense_binomial_table[n][k] == binomial(n, k));
+        iteration++;
+      });
+  assert(iteration == binomial_table.size());
+
+#if __cplusplus >= 201703L
+  /// [make_table]
+  constexpr auto products = make_table<for_bounds<0, 3>, for_bounds<0, 3>>(
+      [](auto i, auto j) { return static_cast<double>(i * j); });
+  static_assert(products[5] == 2.0);
+  /// [make_table]
+#endif
+}
+
+void early_exit() {
+  constexpr size_t dim = 3;
+  {  // runtime break out of all loops
+    /// [early_exit]
+    const std::array<double, dim * dim> values{
+        {0.0, 0.1, 0.2, 0.1, 0.5, 2.0, 0.2, 2.0, 3.0}};
+    size_t invocations = 0;
+    size_t first_i = dim;
+    size_t first_j = dim;
+    for_constexpr<for_bounds<0, dim>, for_symm_upper<0, dim>>(
+        [&](auto i, auto j) {
+          invocations++;
+          if (values[i * dim + j] > 1.0) {
+            first_i = i;
+            first_j = j;
+            return for_control::break_all;
+          }
+          return for_control::continue_loop;
+        });
+    assert(first_i == 1 and first_j == 2);
+    assert(invocations == 5);
+    /// [early_exit]
+  }
+  {  // runtime break out of the innermost loop only
+    std::array<std::array<size_t, dim>, dim> visited{};
+    for_constexpr<for_bounds<0, dim>, for_bounds<0, dim>, for_bounds<0, dim>>(
+        [&visited](auto i, auto j, auto k) {
+          visited[i][j]++;
+          return k == j ? for_control::break_inner : for_control::continue_loop;
+        });
+    for (size_t i = 0; i < dim; ++i) {
+      for (size_t j = 0; j < dim; ++j) {
+        assert(visited[i][j] == j + 1);
+      }
+    }
+  }
+  {  // compile-time break, later iterations are never instantiated
+    size_t invocations = 0;
+    for_constexpr<for_bounds<0, 1000>>([&invocations](auto i) {
+      static_assert(decltype(i)::value <= 2, "Instantiated after a break");
+      invocations++;
+      return std::conditional_t<(decltype(i)::value < 2), for_continue_t,
+                                for_break_all_t>{};
+    });
+    assert(invocations == 3);
+    invocations = 0;
+    for_constexpr<for_bounds<0, dim>, for_bounds<0, 1000>>(
+        [&invocations](auto /*i*/, auto j) {
+          static_assert(decltype(j)::value == 0, "Instantiated after a break");
+          invocations++;
+          return for_break_inner;
+        });
+    assert(invocations == dim);
+  }
+  {  // fully symmetric loops
+    size_t invocations = 0;
+    for_constexpr<for_symm_all<2, dim>>(
+        [&invocations](auto i, auto /*j*/, auto /*multiplicity*/) {
+          invocations++;
+          return i == 1 ? for_control::break_all : for_control::continue_loop;
+        });
+    assert(invocations == 4);
+  }
+  {  // bodies returning anything else run every iteration
+    std::array<size_t, dim> a{};
+    for_constexpr<for_bounds<0, dim>>([&a](auto i) { return a[i] = i + 1; });
+    assert(a[0] == 1 and a[1] == 2 and a[2] == 3);
+    size_t invocations = 0;
+    for_constexpr<for_bounds<0, dim>, for_symm_lower<0, 0, 1>>(
+        [&invocations](auto /*i*/, auto /*j*/) -> size_t& {
+          return ++invocations;
+        });
+    assert(invocations == 6);
+  }
+}
+
+void runtime_dispatch() {
+  /// [dispatch_bounds]
+  const std::array<double, 3> a{{1.0, 2.0, 3.0}};
+  const std::array<double, 3> b{{4.0, 5.0, 6.0}};
+  const auto dot = [&a, &b](const size_t dim) {
+    return dispatch_bounds<for_bounds<1, 4>>(dim, [&a, &b](auto n) {
+      double result = 0.0;
+      for_constexpr<for_bounds<0, decltype(n)::value>>(
+          [&result, &a, &b](auto i) { result += a[i] * b[i]; });
+      return result;
+    });
+  };
+  assert(dot(1) == 4.0);
+  assert(dot(2) == 14.0);
+  assert(dot(3) == 32.0);
+  /// [dispatch_bounds]
+
+  // Several runtime values, dispatched through a single table
+  for (size_t dim = 1; dim < 4; ++dim) {
+    for (size_t order = 2; order < 17; ++order) {
+      dispatch_bounds<for_bounds<1, 4>, for_bounds<2, 17>>(
+          dim, order, [dim, order](auto d, auto o) {
+            assert(d == dim and o == order);
+          });
+    }
+  }
+
+  bool threw = false;
+  try {
+    dispatch_bounds<for_bounds<1, 4>>(4, [](auto /*n*/) {});
+  } catch (const std::out_of_range& /*e*/) {
+    threw = true;
+  }
+  assert(threw);
+}
+
+void iteration_space_traits() {
+  constexpr size_t array_size = 3;
+  using rectangular =
+      for_constexpr_traits<for_bounds<0, array_size>, for_bounds<1, array_size>>;
+  static_assert(rectangular::depth == 2, "");
+  static_assert(rectangular::iterations == 6, "");
+  static_assert(rectangular::is_rectangular, "");
+  static_assert(rectangular::min_index[1] == 1 and rectangular::max_index[1] == 2,
+                "");
+  static_assert(rectangular::indices[4][0] == 2 and
+                    rectangular::indices[4][1] == 1,
+                "");
+
+  /// [iteration_space_traits]
+  using symmetric =
+      for_constexpr_traits<for_bounds<0, array_size>, for_symm_lower<0, 0, 1>,
+                           for_symm_upper<1, array_size>>;
+  static_assert(symmetric::iterations == 14, "");
+  static_assert(not symmetric::is_rectangular, "");
+  static_assert(symmetric::min_extent[1] == 1 and symmetric::max_extent[1] == 3,
+                "");
+  static_assert(symmetric::min_extent[2] == 1 and symmetric::max_extent[2] == 3,
+                "");
+  /// [iteration_space_traits]
+
+  size_t iteration = 0;
+  for_constexpr<for_bounds<0, array_size>, for_symm_lower<0, 0, 1>,
+                for_symm_upper<1, array_size>>(
+      [&iteration](auto i, auto j, auto k) {
+        assert(symmetric::indices[iteration][0] == i);
+        assert(symmetric::indices[iteration][1] == j);
+        assert(symmetric::indices[iteration][2] == k);
+        iteration++;
+      });
+  assert(iteration == symmetric::iterations);
+
+  using empty = for_constexpr_traits<for_bounds<0, array_size>,
+                                     for_symm_lower<0, 0>, for_bounds<0, 2>>;
+  static_assert(empty::iterations == 6, "");
+  static_assert(empty::min_extent[1] == 0 and empty::max_extent[1] == 2, "");
+}
 }  // namespace
 
 int main() {
@@ -976,4 +947,10 @@ int main() {
   triple_loop();
   triple_loop_mixed();
   triple_loop_lower_symmetric();
+  quadruple_loop_symmetric();
+  fully_symmetric_loops();
+  early_exit();
+  runtime_dispatch();
+  iteration_space_traits();
+  lookup_tables();
 }
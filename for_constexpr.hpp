@@ -0,0 +1,1223 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "instrumentation.hpp"
+
+using ssize_t = typename std::make_signed<std::size_t>::type;
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define ALWAYS_INLINE __attribute__((always_inline)) inline
+#elif defined(_MSC_VER) && !defined(__INTEL_COMPILER)
+#define ALWAYS_INLINE __forceinline inline
+#else
+#define ALWAYS_INLINE inline  // :(
+#endif
+
+// Lambdas cannot be declared `inline`, so they only take the attribute, as in
+// `[](auto i) ALWAYS_INLINE_LAMBDA { ... }`
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define ALWAYS_INLINE_LAMBDA __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE_LAMBDA
+#endif
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Specify the lower and upper bounds in a for_constexpr loop
+ *
+ * \see for_constexpr for_symm_lower for_symm_upper
+ */
+template <size_t Lower, size_t Upper>
+struct for_bounds {
+  static constexpr const size_t lower = Lower;
+  static constexpr const size_t upper = Upper;
+};
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Specify the loop index to symmetrize over, the lower bound, and an
+ * offset to add to `Index`'s current loop value in a for_constexpr loop. Loops
+ * from `Lower` to `Index`'s current loop value plus `Offset`.
+ *
+ * \see for_constexpr for_bounds for_symm_upper
+ */
+template <size_t Index, size_t Lower, ssize_t Offset = 0>
+struct for_symm_lower {};
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Specify the loop index to symmetrize over and upper bounds in a
+ * for_constexpr loop. Loops from the `Index`'s current loop value to `Upper`.
+ *
+ * \see for_constexpr for_bounds for_symm_lower
+ */
+template <size_t Index, size_t Upper>
+struct for_symm_upper {};
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Loop over the independent components of a fully symmetric rank
+ * `Rank` tensor in `Dim` dimensions. Must be the only bounds of the
+ * for_constexpr loop.
+ *
+ * The body is called with the `Rank` non-decreasing indices, \f$i_0 \le i_1
+ * \le \dots\f$, followed by the multiplicity of the component, which is the
+ * number of distinct permutations of the indices, as a
+ * `std::integral_constant<size_t, ...>`.
+ *
+ * \see for_constexpr for_antisymm_all
+ */
+template <size_t Rank, size_t Dim>
+struct for_symm_all {};
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Loop over the independent components of a fully antisymmetric rank
+ * `Rank` tensor in `Dim` dimensions. Must be the only bounds of the
+ * for_constexpr loop.
+ *
+ * The body is called with the `Rank` strictly increasing indices, \f$i_0 <
+ * i_1 < \dots\f$, followed by the multiplicity of the component, `Rank!`, as a
+ * `std::integral_constant<size_t, ...>`. Each permutation contributes with the
+ * sign of the permutation.
+ *
+ * \see for_constexpr for_symm_all
+ */
+template <size_t Rank, size_t Dim>
+struct for_antisymm_all {};
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief What a for_constexpr loop does after an invocation of its body.
+ *
+ * - `continue_loop`: continue with the next iteration
+ * - `break_inner`: stop the innermost loop and continue with the next
+ *   iteration of the enclosing loop
+ * - `break_all`: stop all loops
+ *
+ * A body returning a `for_control` is checked after every invocation. A body
+ * returning one of the compile-time values `for_continue`, `for_break_inner`
+ * and `for_break_all` is dispatched on at compile time, so the iterations after
+ * a break are never instantiated. A body that returns different values on
+ * different paths must return `for_control`, e.g. `[](auto i) -> for_control`.
+ * Bodies returning `void` or any other type run every iteration, and the
+ * returned value is discarded.
+ *
+ * \see for_constexpr
+ */
+enum class for_control { continue_loop, break_inner, break_all };
+
+/// \cond
+using for_continue_t =
+    std::integral_constant<for_control, for_control::continue_loop>;
+using for_break_inner_t =
+    std::integral_constant<for_control, for_control::break_inner>;
+using for_break_all_t =
+    std::integral_constant<for_control, for_control::break_all>;
+/// \endcond
+
+constexpr for_continue_t for_continue{};
+constexpr for_break_inner_t for_break_inner{};
+constexpr for_break_all_t for_break_all{};
+
+namespace for_constexpr_detail {
+// Provided for implementation to be self-contained
+template <bool...>
+struct bool_pack;
+template <bool... Bs>
+using all_true = std::is_same<bool_pack<Bs..., true>, bool_pack<true, Bs...>>;
+
+// Base case
+template <size_t Lower, size_t... Is, class F, class... IntegralConstants>
+ALWAYS_INLINE constexpr void for_constexpr_impl(
+    F&& f, std::index_sequence<Is...> /*meta*/, IntegralConstants... v) {
+  TMPL_INSTRUMENT_TAG(instrumentation::call_site_tag<
+                      instrumentation::for_constexpr_site, std::decay_t<F>>);
+  (void)std::initializer_list<char>{
+      ((void)TMPL_INSTRUMENT_ELEMENT(
+           Is + Lower, f(v..., std::integral_constant<size_t, Is + Lower>{})),
+       '0')...};
+}
+
+// Cases of second last loop
+template <size_t Lower, size_t BoundsNextLower, size_t BoundsNextUpper,
+          size_t... Is, class F, class... IntegralConstants>
+ALWAYS_INLINE constexpr void for_constexpr_impl(
+    F&& f, for_bounds<BoundsNextLower, BoundsNextUpper> /*meta*/,
+    std::index_sequence<Is...> /*meta*/, IntegralConstants... v) {
+  static_assert(static_cast<ssize_t>(BoundsNextUpper) -
+                        static_cast<ssize_t>(BoundsNextLower) >=
+                    0,
+                "Cannot make index_sequence of negative size. The upper bound "
+                "in for_bounds is smaller than the lower bound.");
+  (void)std::initializer_list<char>{
+      ((void)for_constexpr_impl<BoundsNextLower>(
+           std::forward<F>(f),
+           std::make_index_sequence<(  // Safeguard against generating
+                                       // index_sequence of size ~ max size_t
+               static_cast<ssize_t>(BoundsNextUpper) -
+                           static_cast<ssize_t>(BoundsNextLower) <
+                       0
+                   ? 1
+                   : BoundsNextUpper - BoundsNextLower)>{},
+           v..., std::integral_constant<size_t, Is + Lower>{}),
+       '0')...};
+}
+
+template <size_t Lower, size_t BoundsNextIndex, size_t BoundsNextUpper,
+          size_t... Is, class F, class... IntegralConstants>
+ALWAYS_INLINE constexpr void for_constexpr_impl(
+    F&& f, for_symm_upper<BoundsNextIndex, BoundsNextUpper> /*meta*/,
+    std::index_sequence<Is...> /*meta*/, IntegralConstants... v) {
+  static_assert(all_true<(static_cast<ssize_t>(BoundsNextUpper) -
+                              static_cast<ssize_t>(std::get<BoundsNextIndex>(
+                                  std::make_tuple(IntegralConstants::value...,
+                                                  Is + Lower))) >=
+                          0)...>::value,
+                "Cannot make index_sequence of negative size. You specified an "
+                "upper bound in for_symm_upper that is less than the "
+                "smallest lower bound in the loop being symmetrized over.");
+  (void)std::initializer_list<char>{
+      ((void)for_constexpr_impl<std::get<BoundsNextIndex>(
+           std::make_tuple(IntegralConstants::value..., Is + Lower))>(
+           std::forward<F>(f),
+           std::make_index_sequence<(  // Safeguard against generating
+                                       // index_sequence of size ~ max size_t
+               static_cast<ssize_t>(BoundsNextUpper) -
+                           static_cast<ssize_t>(
+                               std::get<BoundsNextIndex>(std::make_tuple(
+                                   IntegralConstants::value..., Is + Lower))) <
+                       0
+                   ? 1
+                   : BoundsNextUpper -
+                         std::get<BoundsNextIndex>(std::make_tuple(
+                             IntegralConstants::value..., Is + Lower)))>{},
+           v..., std::integral_constant<size_t, Is + Lower>{}),
+       '0')...};
+}
+
+template <size_t Lower, size_t BoundsNextIndex, size_t BoundsNextLower,
+          ssize_t BoundsNextOffset, size_t... Is, class F,
+          class... IntegralConstants>
+ALWAYS_INLINE constexpr void for_constexpr_impl(
+    F&& f,
+    for_symm_lower<BoundsNextIndex, BoundsNextLower, BoundsNextOffset> /*meta*/,
+    std::index_sequence<Is...> /*meta*/, IntegralConstants... v) {
+  static_assert(
+      all_true<(static_cast<ssize_t>(std::get<BoundsNextIndex>(
+                    std::make_tuple(IntegralConstants::value..., Is + Lower))) +
+                    BoundsNextOffset - static_cast<ssize_t>(BoundsNextLower) >=
+                0)...>::value,
+      "Cannot make index_sequence of negative size. You specified a lower "
+      "bound in for_symm_lower that is larger than the upper bounds of "
+      "the loop being symmetrized over");
+  (void)std::initializer_list<char>{
+      ((void)for_constexpr_impl<BoundsNextLower>(
+           std::forward<F>(f),
+           std::make_index_sequence<(  // Safeguard against generating
+                                       // index_sequence of size ~ max size_t
+               static_cast<ssize_t>(std::get<BoundsNextIndex>(
+                   std::make_tuple(IntegralConstants::value..., Is + Lower))) +
+                           BoundsNextOffset -
+                           static_cast<ssize_t>(BoundsNextLower) <
+                       0
+                   ? 1
+                   : static_cast<size_t>(
+                         static_cast<ssize_t>(
+                             std::get<BoundsNextIndex>(std::make_tuple(
+                                 IntegralConstants::value..., Is + Lower))) +
+                         BoundsNextOffset -
+                         static_cast<ssize_t>(BoundsNextLower)))>{},
+           v..., std::integral_constant<size_t, Is + Lower>{}),
+       '0')...};
+}
+
+// Handle cases of more than two nested loops
+template <size_t Lower, class Bounds1, class... Bounds, size_t BoundsNextLower,
+          size_t BoundsNextUpper, size_t... Is, class F,
+          class... IntegralConstants>
+ALWAYS_INLINE constexpr void for_constexpr_impl(
+    F&& f, for_bounds<BoundsNextLower, BoundsNextUpper> /*meta*/,
+    std::index_sequence<Is...> /*meta*/, IntegralConstants... v) {
+  static_assert(static_cast<ssize_t>(BoundsNextUpper) -
+                        static_cast<ssize_t>(BoundsNextLower) >=
+                    0,
+                "Cannot make index_sequence of negative size. The upper bound "
+                "in for_bounds is smaller than the lower bound.");
+
+  (void)std::initializer_list<char>{
+      ((void)for_constexpr_impl<BoundsNextLower, Bounds...>(
+           std::forward<F>(f), Bounds1{},
+           std::make_index_sequence<(  // Safeguard against generating
+                                       // index_sequence of size ~ max size_t
+               static_cast<ssize_t>(BoundsNextUpper) -
+                           static_cast<ssize_t>(BoundsNextLower) <
+                       0
+                   ? 1
+                   : BoundsNextUpper - BoundsNextLower)>{},
+           v..., std::integral_constant<size_t, Is + Lower>{}),
+       '0')...};
+}
+
+template <size_t Lower, class Bounds1, class... Bounds, size_t BoundsNextIndex,
+          size_t BoundsNextUpper, size_t... Is, class F,
+          class... IntegralConstants>
+ALWAYS_INLINE constexpr void for_constexpr_impl(
+    F&& f, for_symm_upper<BoundsNextIndex, BoundsNextUpper> /*meta*/,
+    std::index_sequence<Is...> /*meta*/, IntegralConstants... v) {
+  static_assert(all_true<(static_cast<ssize_t>(BoundsNextUpper) -
+                              static_cast<ssize_t>(std::get<BoundsNextIndex>(
+                                  std::make_tuple(IntegralConstants::value...,
+                                                  Is + Lower))) >=
+                          0)...>::value,
+                "Cannot make index_sequence of negative size. You specified an "
+                "upper bound in for_symm_upper that is less than the "
+                "smallest lower bound in the loop being symmetrized over.");
+  (void)std::initializer_list<char>{
+      ((void)for_constexpr_impl<
+           std::get<BoundsNextIndex>(
+               std::make_tuple(IntegralConstants::value..., Is + Lower)),
+           Bounds...>(
+           std::forward<F>(f), Bounds1{},
+           std::make_index_sequence<(  // Safeguard against generating
+                                       // index_sequence of size ~ max size_t
+               static_cast<ssize_t>(BoundsNextUpper) -
+                           static_cast<ssize_t>(
+                               std::get<BoundsNextIndex>(std::make_tuple(
+                                   IntegralConstants::value..., Is + Lower))) <
+                       0
+                   ? 1
+                   : BoundsNextUpper -
+                         std::get<BoundsNextIndex>(std::make_tuple(
+                             IntegralConstants::value..., Is + Lower)))>{},
+           v..., std::integral_constant<size_t, Is + Lower>{}),
+       '0')...};
+}
+
+template <size_t Lower, class Bounds1, class... Bounds, size_t BoundsNextIndex,
+          size_t BoundsNextLower, ssize_t BoundsNextOffset, size_t... Is,
+          class F, class... IntegralConstants>
+ALWAYS_INLINE constexpr void for_constexpr_impl(
+    F&& f,
+    for_symm_lower<BoundsNextIndex, BoundsNextLower, BoundsNextOffset> /*meta*/,
+    std::index_sequence<Is...> /*meta*/, IntegralConstants... v) {
+  static_assert(
+      all_true<(static_cast<ssize_t>(std::get<BoundsNextIndex>(
+                    std::make_tuple(IntegralConstants::value..., Is + Lower))) +
+                    BoundsNextOffset - static_cast<ssize_t>(BoundsNextLower) >=
+                0)...>::value,
+      "Cannot make index_sequence of negative size. You specified a lower "
+      "bound in for_symm_lower that is larger than the upper bounds of "
+      "the loop being symmetrized over");
+  (void)std::initializer_list<char>{
+      ((void)for_constexpr_impl<BoundsNextLower, Bounds...>(
+           std::forward<F>(f), Bounds1{},
+           std::make_index_sequence<(  // Safeguard against generating
+                                       // index_sequence of size ~ max size_t
+               static_cast<ssize_t>(std::get<BoundsNextIndex>(
+                   std::make_tuple(IntegralConstants::value..., Is + Lower))) +
+                           BoundsNextOffset -
+                           static_cast<ssize_t>(BoundsNextLower) <
+                       0
+                   ? 1
+                   : static_cast<size_t>(
+                         static_cast<ssize_t>(
+                             std::get<BoundsNextIndex>(std::make_tuple(
+                                 IntegralConstants::value..., Is + Lower))) +
+                         BoundsNextOffset -
+                         static_cast<ssize_t>(BoundsNextLower)))>{},
+           v..., std::integral_constant<size_t, Is + Lower>{}),
+       '0')...};
+}
+
+// A runtime description of one loop of a for_constexpr nest. For for_bounds
+// `index` is unused, for for_symm_lower `upper` is unused, and for
+// for_symm_upper `lower` is unused.
+struct loop_description {
+  enum class kind { bounds, symm_lower, symm_upper };
+
+  kind loop_kind;
+  size_t index;
+  size_t lower;
+  size_t upper;
+  ssize_t offset;
+};
+
+template <size_t Lower, size_t Upper>
+constexpr loop_description describe_loop(for_bounds<Lower, Upper> /*meta*/) {
+  return {loop_description::kind::bounds, 0, Lower, Upper, 0};
+}
+
+template <size_t Index, size_t Lower, ssize_t Offset>
+constexpr loop_description describe_loop(
+    for_symm_lower<Index, Lower, Offset> /*meta*/) {
+  return {loop_description::kind::symm_lower, Index, Lower, 0, Offset};
+}
+
+template <size_t Index, size_t Upper>
+constexpr loop_description describe_loop(
+    for_symm_upper<Index, Upper> /*meta*/) {
+  return {loop_description::kind::symm_upper, Index, 0, Upper, 0};
+}
+
+// The first and one past the last value of `loop` given the values of the
+// enclosing loop indices
+constexpr size_t loop_begin(const loop_description& loop,
+                            const size_t* const values) {
+  return loop.loop_kind == loop_description::kind::symm_upper
+             ? values[loop.index]
+             : loop.lower;
+}
+
+constexpr size_t loop_end(const loop_description& loop,
+                          const size_t* const values) {
+  const ssize_t end =
+      loop.loop_kind == loop_description::kind::symm_lower
+          ? static_cast<ssize_t>(values[loop.index]) + loop.offset
+          : static_cast<ssize_t>(loop.upper);
+  const size_t begin = loop_begin(loop, values);
+  return end > static_cast<ssize_t>(begin) ? static_cast<size_t>(end) : begin;
+}
+
+template <class Bounds0, size_t... Values>
+constexpr size_t range_begin() {
+  const size_t values[] = {Values..., 0};
+  return loop_begin(describe_loop(Bounds0{}), values);
+}
+
+template <class Bounds0, size_t... Values>
+constexpr size_t range_end() {
+  const size_t values[] = {Values..., 0};
+  return loop_end(describe_loop(Bounds0{}), values);
+}
+
+// The value of loop `Level` when every loop starts at its lower bound
+template <size_t Level, class... Bounds>
+constexpr size_t first_index() {
+  const loop_description loops[] = {describe_loop(Bounds{})...};
+  size_t values[sizeof...(Bounds)] = {};
+  for (size_t level = 0; level <= Level; ++level) {
+    values[level] = loop_begin(loops[level], values);
+  }
+  return values[Level];
+}
+
+// Whether `T` is one of the values a body returns to control the loop
+template <class T>
+struct is_for_control : std::false_type {};
+
+template <>
+struct is_for_control<for_control> : std::true_type {};
+
+template <for_control Control>
+struct is_for_control<std::integral_constant<for_control, Control>>
+    : std::true_type {};
+
+template <class F, class... Bounds, size_t... Levels>
+constexpr is_for_control<std::decay_t<decltype(std::declval<F&>()(
+    std::integral_constant<size_t, first_index<Levels, Bounds...>()>{}...))>>
+returns_control(std::index_sequence<Levels...> /*meta*/) {
+  return {};
+}
+
+// Bodies that return a for_control are invoked one at a time: after each
+// invocation controlled_next either continues with controlled_iterate or
+// returns how the enclosing loop should continue. Inner loops only ever
+// return for_continue or for_break_all to their enclosing loop.
+template <class F, class... IntegralConstants>
+ALWAYS_INLINE constexpr for_continue_t controlled_call(
+    F& f, std::false_type /*returns_control*/, IntegralConstants... v) {
+  (void)f(v...);
+  return {};
+}
+
+template <class F, class... IntegralConstants>
+ALWAYS_INLINE constexpr std::decay_t<decltype(std::declval<F&>()(
+    std::declval<IntegralConstants>()...))>
+controlled_call(F& f, std::true_type /*returns_control*/,
+                IntegralConstants... v) {
+  return f(v...);
+}
+
+template <class Bounds0, class... Bounds, class F, class... IntegralConstants>
+ALWAYS_INLINE constexpr auto controlled_loop(F& f, IntegralConstants... v);
+
+template <class F, class... IntegralConstants>
+ALWAYS_INLINE constexpr auto controlled_step(F& f, IntegralConstants... v) {
+  return controlled_call(
+      f, is_for_control<std::decay_t<decltype(f(v...))>>{}, v...);
+}
+
+template <class Bounds0, class... Bounds, class F, class... IntegralConstants>
+ALWAYS_INLINE constexpr auto controlled_step(F& f, IntegralConstants... v) {
+  return controlled_loop<Bounds0, Bounds...>(f, v...);
+}
+
+template <size_t I, size_t End, class... Bounds, class F,
+          class... IntegralConstants>
+ALWAYS_INLINE constexpr for_continue_t controlled_iterate(
+    F& /*f*/, std::false_type /*in_range*/, IntegralConstants... /*v*/) {
+  return {};
+}
+
+template <size_t I, size_t End, class... Bounds, class F,
+          class... IntegralConstants>
+ALWAYS_INLINE constexpr auto controlled_iterate(F& f,
+                                                std::true_type /*in_range*/,
+                                                IntegralConstants... v);
+
+template <size_t I, size_t End, class... Bounds, class F,
+          class... IntegralConstants>
+ALWAYS_INLINE constexpr auto controlled_next(F& f, for_continue_t /*meta*/,
+                                             IntegralConstants... v) {
+  return controlled_iterate<I + 1, End, Bounds...>(
+      f, std::integral_constant<bool, (I + 1 < End)>{}, v...);
+}
+
+template <size_t I, size_t End, class... Bounds, class F,
+          class... IntegralConstants>
+ALWAYS_INLINE constexpr for_continue_t controlled_next(
+    F& /*f*/, for_break_inner_t /*meta*/, IntegralConstants... /*v*/) {
+  return {};
+}
+
+template <size_t I, size_t End, class... Bounds, class F,
+          class... IntegralConstants>
+ALWAYS_INLINE constexpr for_break_all_t controlled_next(
+    F& /*f*/, for_break_all_t /*meta*/, IntegralConstants... /*v*/) {
+  return {};
+}
+
+template <size_t I, size_t End, class... Bounds, class F,
+          class... IntegralConstants>
+ALWAYS_INLINE constexpr for_control controlled_next(F& f,
+                                                    const for_control control,
+                                                    IntegralConstants... v) {
+  if (control == for_control::continue_loop) {
+    return controlled_iterate<I + 1, End, Bounds...>(
+        f, std::integral_constant<bool, (I + 1 < End)>{}, v...);
+  }
+  return control == for_control::break_all ? for_control::break_all
+                                           : for_control::continue_loop;
+}
+
+template <size_t I, size_t End, class... Bounds, class F,
+          class... IntegralConstants>
+ALWAYS_INLINE constexpr auto controlled_iterate(F& f,
+                                                std::true_type /*in_range*/,
+                                                IntegralConstants... v) {
+  return controlled_next<I, End, Bounds...>(
+      f,
+      controlled_step<Bounds...>(f, v..., std::integral_constant<size_t, I>{}),
+      v...);
+}
+
+template <class Bounds0, class... Bounds, class F, class... IntegralConstants>
+ALWAYS_INLINE constexpr auto controlled_loop(F& f, IntegralConstants... v) {
+  constexpr size_t begin = range_begin<Bounds0, IntegralConstants::value...>();
+  constexpr size_t end = range_end<Bounds0, IntegralConstants::value...>();
+  return controlled_iterate<begin, end, Bounds...>(
+      f, std::integral_constant<bool, (begin < end)>{}, v...);
+}
+
+// Runs the loop nest, expanding every iteration unless the body returns a
+// for_control or one of for_continue, for_break_inner and for_break_all
+template <class Bounds0, class F>
+ALWAYS_INLINE constexpr void for_constexpr_nest(
+    F&& f, std::false_type /*returns_control*/) {
+  for_constexpr_impl<Bounds0::lower>(
+      std::forward<F>(f),
+      std::make_index_sequence<(
+          static_cast<ssize_t>(Bounds0::upper) -
+                      static_cast<ssize_t>(Bounds0::lower) <
+                  0
+              ? 1
+              : Bounds0::upper - Bounds0::lower)>{});
+}
+
+template <class Bounds0, class Bounds1, class... Bounds, class F>
+ALWAYS_INLINE constexpr void for_constexpr_nest(
+    F&& f, std::false_type /*returns_control*/) {
+  for_constexpr_impl<Bounds0::lower, Bounds...>(
+      std::forward<F>(f), Bounds1{},
+      std::make_index_sequence<(
+          static_cast<ssize_t>(Bounds0::upper) -
+                      static_cast<ssize_t>(Bounds0::lower) <
+                  0
+              ? 1
+              : Bounds0::upper - Bounds0::lower)>{});
+}
+
+template <class... Bounds, class F>
+ALWAYS_INLINE constexpr void for_constexpr_nest(
+    F&& f, std::true_type /*returns_control*/) {
+  (void)controlled_loop<Bounds...>(f);
+}
+
+template <class... Bounds, class F>
+ALWAYS_INLINE constexpr void for_constexpr_nest(F&& f) {
+  for_constexpr_nest<Bounds...>(
+      std::forward<F>(f),
+      returns_control<std::remove_reference_t<F>, Bounds...>(
+          std::make_index_sequence<sizeof...(Bounds)>{}));
+}
+
+// Single loops, dispatched on the bounds
+template <size_t Lower, size_t Upper, class F>
+ALWAYS_INLINE constexpr void for_constexpr_single(
+    F&& f, for_bounds<Lower, Upper> /*meta*/) {
+  static_assert(static_cast<ssize_t>(Upper) - static_cast<ssize_t>(Lower) >= 0,
+                "Cannot make index_sequence of negative size. The upper bound "
+                "in for_bounds is smaller than the lower bound.");
+  for_constexpr_nest<for_bounds<Lower, Upper>>(std::forward<F>(f));
+}
+
+constexpr size_t factorial(const size_t n) {
+  return n <= 1 ? 1 : n * factorial(n - 1);
+}
+
+// The number of distinct permutations of the sorted `Indices`, dividing
+// `Rank!` by the factorial of the length of each run of equal indices
+template <size_t... Indices>
+constexpr size_t multiplicity() {
+  const size_t indices[] = {Indices...};
+  size_t result = factorial(sizeof...(Indices));
+  size_t run = 1;
+  for (size_t i = 1; i < sizeof...(Indices); ++i) {
+    run = indices[i] == indices[i - 1] ? run + 1 : 1;
+    result /= run;
+  }
+  return result;
+}
+
+// Wraps the body of a for_symm_all or for_antisymm_all loop, which is run as
+// the non-decreasing for_symm_upper chain. Strictly increasing indices are
+// obtained by adding its position to each index of a non-decreasing chain in
+// `Rank - 1` fewer dimensions.
+template <bool Antisymmetric, class F, class Positions>
+struct symm_all_body;
+
+template <bool Antisymmetric, class F, size_t... Positions>
+struct symm_all_body<Antisymmetric, F, std::index_sequence<Positions...>> {
+  F& f;
+
+  template <class... IntegralConstants>
+  ALWAYS_INLINE constexpr decltype(auto) operator()(
+      IntegralConstants... /*indices*/) const {
+    constexpr size_t weight =
+        Antisymmetric ? factorial(sizeof...(Positions))
+                      : multiplicity<IntegralConstants::value...>();
+    return f(std::integral_constant<size_t, IntegralConstants::value +
+                                         (Antisymmetric ? Positions : 0)>{}...,
+      std::integral_constant<size_t, weight>{});
+  }
+};
+
+template <size_t Rank, size_t Dim, class Body>
+ALWAYS_INLINE constexpr void symm_all_impl(Body&& body,
+                                           std::true_type /*single_loop*/) {
+  for_constexpr_nest<for_bounds<0, Dim>>(std::forward<Body>(body));
+}
+
+template <size_t Dim, class Body, size_t... Ks>
+ALWAYS_INLINE constexpr void symm_all_chain(
+    Body&& body, std::index_sequence<Ks...> /*meta*/) {
+  for_constexpr_nest<for_bounds<0, Dim>, for_symm_upper<0, Dim>,
+                     for_symm_upper<Ks + 1, Dim>...>(std::forward<Body>(body));
+}
+
+template <size_t Rank, size_t Dim, class Body>
+ALWAYS_INLINE constexpr void symm_all_impl(Body&& body,
+                                           std::false_type /*single_loop*/) {
+  symm_all_chain<Dim>(std::forward<Body>(body),
+                      std::make_index_sequence<Rank - 2>{});
+}
+
+template <size_t Rank, size_t Dim, class F>
+ALWAYS_INLINE constexpr void for_constexpr_single(
+    F&& f, for_symm_all<Rank, Dim> /*meta*/) {
+  static_assert(Rank > 0, "for_symm_all must have a rank of at least one.");
+  symm_all_impl<Rank, Dim>(
+      symm_all_body<false, std::remove_reference_t<F>,
+                    std::make_index_sequence<Rank>>{f},
+      std::integral_constant<bool, Rank == 1>{});
+}
+
+template <size_t Rank, size_t Dim, class F>
+ALWAYS_INLINE constexpr void for_constexpr_single(
+    F&& f, for_antisymm_all<Rank, Dim> /*meta*/) {
+  static_assert(Rank > 0, "for_antisymm_all must have a rank of at least one.");
+  symm_all_impl<Rank, (Rank > Dim ? 0 : Dim - Rank + 1)>(
+      symm_all_body<true, std::remove_reference_t<F>,
+                    std::make_index_sequence<Rank>>{f},
+      std::integral_constant<bool, Rank == 1>{});
+}
+}  // namespace for_constexpr_detail
+
+/// \cond
+template <class Bounds0, class F>
+ALWAYS_INLINE constexpr void for_constexpr(F&& f) {
+  TMPL_INSTRUMENT_TAG(instrumentation::call_site_tag<
+                      instrumentation::for_constexpr_site, std::decay_t<F>>);
+  TMPL_INSTRUMENT_CALL();
+  for_constexpr_detail::for_constexpr_single(std::forward<F>(f), Bounds0{});
+}
+/// \endcond
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Allows nested constexpr for loops including symmetrizing over loops.
+ *
+ * \note All upper bounds are exclusive (the comparator is a strict less than,
+ * `<`)
+ * \note You must loop over non-negative numbers.
+ *
+ * The `for_bounds` class is used for specifying the lower (first template
+ * parameter) and upper (second template parameter) bounds for a single loop.
+ * Symmetrizing over loops is supported via the `for_symm_lower` and
+ * `for_symm_upper` classes. `for_symm_lower` takes two template parameters (and
+ * a third optional one): the integer corresponding to the outer loop to
+ * symmetrize over, the lower bound of the loop, and optionally an integer to
+ * add to the upper bound obtained from the loop being symmetrized over.
+ * This is equivalent to loops of the form:
+ *
+ * \code
+ * for (size_t i = 0; i < Dim; ++i) {
+ *   for (size_t j = param1; j < i + param2; ++j) {
+ *   }
+ * }
+ * \endcode
+ *
+ * `for_symm_upper` takes two template parameters. The first is the integer
+ * corresponding to the outer loop being symmetrized over, and the second is the
+ * upper bound. This is equivalent to loops of the form
+ *
+ * \code
+ * for (size_t i = 0; i < Dim; ++i) {
+ *   for (size_t j = j; j < param1; ++j) {
+ *   }
+ * }
+ * \endcode
+ *
+ * The body may return a for_control to skip the rest of the innermost loop or
+ * of the whole nest.
+ *
+ * For fully symmetric or antisymmetric tensors pass `for_symm_all<Rank, Dim>`
+ * or `for_antisymm_all<Rank, Dim>` as the only bounds. These loop over each
+ * independent component once and additionally pass its multiplicity to the
+ * body.
+ *
+ * \example
+ * Here are various example use cases of different loop structures. The runtime
+ * for loops are shown for comparison. Only the elements that are 1 were mutated
+ * by the `for_constexpr`.
+ *
+ * #### Single loops
+ * Single loops are hopefully straightforward.
+ * \snippet Test_ForConstexpr.cpp single_loop
+ *
+ * #### Double loops
+ * For double loops we should the four different options for loop symmetries.
+ * \snippet Test_ForConstexpr.cpp double_loop
+ * \snippet Test_ForConstexpr.cpp double_symm_lower_inclusive
+ * \snippet Test_ForConstexpr.cpp double_symm_lower_exclusive
+ * \snippet Test_ForConstexpr.cpp double_symm_upper
+ *
+ * #### Triple loops
+ * For triple loops we only show the double symmetrized loops, since the others
+ * are very similar to the double loop case.
+ * \snippet Test_ForConstexpr.cpp triple_symm_lower_lower
+ * \snippet Test_ForConstexpr.cpp triple_symm_upper_lower
+ *
+ * #### Fully symmetric loops
+ * \snippet Test_ForConstexpr.cpp symm_all
+ *
+ * #### Early exit
+ * \snippet Test_ForConstexpr.cpp early_exit
+ *
+ * \see for_bounds for_symm_lower for_symm_upper for_symm_all for_antisymm_all
+ */
+template <class Bounds0, class Bounds1, class... Bounds, class F>
+ALWAYS_INLINE constexpr void for_constexpr(F&& f) {
+  TMPL_INSTRUMENT_TAG(instrumentation::call_site_tag<
+                      instrumentation::for_constexpr_site, std::decay_t<F>>);
+  TMPL_INSTRUMENT_CALL();
+  static_assert(static_cast<ssize_t>(Bounds0::upper) -
+                        static_cast<ssize_t>(Bounds0::lower) >=
+                    0,
+                "Cannot make index_sequence of negative size. The upper bound "
+                "in for_bounds is smaller than the lower bound.");
+  for_constexpr_detail::for_constexpr_nest<Bounds0, Bounds1, Bounds...>(
+      std::forward<F>(f));
+}
+
+namespace for_constexpr_detail {
+template <size_t Depth>
+struct iteration_space {
+  size_t iterations = 0;
+  size_t min_index[Depth] = {};
+  size_t max_index[Depth] = {};
+  size_t min_extent[Depth] = {};
+  size_t max_extent[Depth] = {};
+  bool visited[Depth] = {};
+  // The loop indices of iteration number `target`
+  size_t target = 0;
+  size_t target_indices[Depth] = {};
+};
+
+template <size_t Depth>
+constexpr void walk_iteration_space(const loop_description* const loops,
+                                    const size_t level, size_t* const values,
+                                    iteration_space<Depth>& space) {
+  const size_t lower = loop_begin(loops[level], values);
+  const size_t upper = loop_end(loops[level], values);
+  const size_t extent = upper - lower;
+  if (not space.visited[level] or extent < space.min_extent[level]) {
+    space.min_extent[level] = extent;
+  }
+  if (extent > space.max_extent[level]) {
+    space.max_extent[level] = extent;
+  }
+  space.visited[level] = true;
+  for (size_t value = lower; value < upper; ++value) {
+    values[level] = value;
+    if (level + 1 < Depth) {
+      walk_iteration_space(loops, level + 1, values, space);
+      continue;
+    }
+    for (size_t i = 0; i < Depth; ++i) {
+      if (space.iterations == 0 or values[i] < space.min_index[i]) {
+        space.min_index[i] = values[i];
+      }
+      if (space.iterations == 0 or values[i] > space.max_index[i]) {
+        space.max_index[i] = values[i];
+      }
+      if (space.iterations == space.target) {
+        space.target_indices[i] = values[i];
+      }
+    }
+    ++space.iterations;
+  }
+}
+
+template <class... Bounds>
+constexpr iteration_space<sizeof...(Bounds)> make_iteration_space(
+    const size_t target = 0) {
+  constexpr size_t depth = sizeof...(Bounds);
+  const loop_description loops[depth] = {describe_loop(Bounds{})...};
+  size_t values[depth] = {};
+  iteration_space<depth> space{};
+  space.target = target;
+  walk_iteration_space(loops, 0, values, space);
+  return space;
+}
+
+template <class Bounds>
+struct is_for_bounds : std::false_type {};
+
+template <size_t Lower, size_t Upper>
+struct is_for_bounds<for_bounds<Lower, Upper>> : std::true_type {};
+
+template <size_t Depth, class Array, size_t... Is>
+constexpr std::array<size_t, Depth> to_array(
+    const Array& a, std::index_sequence<Is...> /*meta*/) {
+  return {{a[Is]...}};
+}
+
+template <class... Bounds, size_t... Is>
+constexpr std::array<std::array<size_t, sizeof...(Bounds)>, sizeof...(Is)>
+enumerate_iteration_space(std::index_sequence<Is...> /*meta*/) {
+  return {{to_array<sizeof...(Bounds)>(
+      make_iteration_space<Bounds...>(Is).target_indices,
+      std::make_index_sequence<sizeof...(Bounds)>{})...}};
+}
+}  // namespace for_constexpr_detail
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Compile-time properties of the iteration space of
+ * `for_constexpr<Bounds...>`.
+ *
+ * - `depth`: the number of nested loops
+ * - `iterations`: the number of times the body is invoked
+ * - `is_rectangular`: `true` if no loop is symmetrized over another
+ * - `min_index`/`max_index`: the smallest/largest value of each loop index over
+ *   the whole iteration space
+ * - `min_extent`/`max_extent`: the smallest/largest number of iterations of
+ *   each loop for any values of the outer loop indices
+ * - `indices`: the loop indices of every body invocation, in the order
+ *   for_constexpr invokes the body
+ *
+ * This allows choosing a strategy at compile time, for example checking that a
+ * loop nest is small enough to unroll:
+ *
+ * \code
+ * static_assert(for_constexpr_traits<for_bounds<0, 3>,
+ *                                    for_symm_lower<0, 0, 1>>::iterations <= 64,
+ *               "Too many iterations to unroll");
+ * \endcode
+ *
+ * \see for_constexpr
+ */
+template <class... Bounds>
+struct for_constexpr_traits {
+  static_assert(sizeof...(Bounds) > 0,
+                "for_constexpr_traits needs at least one loop");
+
+  static constexpr size_t depth = sizeof...(Bounds);
+  static constexpr size_t iterations =
+      for_constexpr_detail::make_iteration_space<Bounds...>().iterations;
+  static constexpr bool is_rectangular = for_constexpr_detail::all_true<
+      for_constexpr_detail::is_for_bounds<Bounds>::value...>::value;
+
+  static constexpr std::array<size_t, depth> min_index =
+      for_constexpr_detail::to_array<depth>(
+          for_constexpr_detail::make_iteration_space<Bounds...>().min_index,
+          std::make_index_sequence<depth>{});
+  static constexpr std::array<size_t, depth> max_index =
+      for_constexpr_detail::to_array<depth>(
+          for_constexpr_detail::make_iteration_space<Bounds...>().max_index,
+          std::make_index_sequence<depth>{});
+  static constexpr std::array<size_t, depth> min_extent =
+      for_constexpr_detail::to_array<depth>(
+          for_constexpr_detail::make_iteration_space<Bounds...>().min_extent,
+          std::make_index_sequence<depth>{});
+  static constexpr std::array<size_t, depth> max_extent =
+      for_constexpr_detail::to_array<depth>(
+          for_constexpr_detail::make_iteration_space<Bounds...>().max_extent,
+          std::make_index_sequence<depth>{});
+  static constexpr std::array<std::array<size_t, depth>, iterations> indices =
+      for_constexpr_detail::enumerate_iteration_space<Bounds...>(
+          std::make_index_sequence<iterations>{});
+};
+
+/// \cond
+template <class... Bounds>
+constexpr size_t for_constexpr_traits<Bounds...>::depth;
+template <class... Bounds>
+constexpr size_t for_constexpr_traits<Bounds...>::iterations;
+template <class... Bounds>
+constexpr bool for_constexpr_traits<Bounds...>::is_rectangular;
+template <class... Bounds>
+constexpr std::array<size_t, for_constexpr_traits<Bounds...>::depth>
+    for_constexpr_traits<Bounds...>::min_index;
+template <class... Bounds>
+constexpr std::array<size_t, for_constexpr_traits<Bounds...>::depth>
+    for_constexpr_traits<Bounds...>::max_index;
+template <class... Bounds>
+constexpr std::array<size_t, for_constexpr_traits<Bounds...>::depth>
+    for_constexpr_traits<Bounds...>::min_extent;
+template <class... Bounds>
+constexpr std::array<size_t, for_constexpr_traits<Bounds...>::depth>
+    for_constexpr_traits<Bounds...>::max_extent;
+template <class... Bounds>
+constexpr std::array<std::array<size_t, for_constexpr_traits<Bounds...>::depth>,
+                     for_constexpr_traits<Bounds...>::iterations>
+    for_constexpr_traits<Bounds...>::indices;
+/// \endcond
+
+namespace for_constexpr_detail {
+// The value of `f` at iteration `Iteration` of the loop nest described by
+// `Traits`
+template <class Traits, size_t Iteration, class F, size_t... Ds>
+constexpr decltype(auto) table_entry(const F& f,
+                                     std::index_sequence<Ds...> /*meta*/) {
+  return f(std::integral_constant<size_t,
+                                  Traits::indices[Iteration][Ds]>{}...);
+}
+
+template <class Traits, class F>
+using table_value_t = std::decay_t<decltype(table_entry<Traits, 0>(
+    std::declval<const F&>(), std::make_index_sequence<Traits::depth>{}))>;
+
+template <class Traits, class F, size_t... Is>
+constexpr std::array<table_value_t<Traits, F>, sizeof...(Is)> make_table_impl(
+    const F& f, std::index_sequence<Is...> /*meta*/) {
+  return {{table_entry<Traits, Is>(
+      f, std::make_index_sequence<Traits::depth>{})...}};
+}
+
+template <class T, size_t... Extents>
+struct dense_table;
+
+template <class T>
+struct dense_table<T> {
+  using type = T;
+};
+
+template <class T, size_t Extent, size_t... Extents>
+struct dense_table<T, Extent, Extents...> {
+  using type = std::array<typename dense_table<T, Extents...>::type, Extent>;
+};
+
+template <class Traits, size_t... Is>
+constexpr bool in_iteration_space() {
+  const size_t indices[] = {Is...};
+  for (size_t iteration = 0; iteration < Traits::iterations; ++iteration) {
+    bool equal = true;
+    for (size_t d = 0; d < Traits::depth; ++d) {
+      equal = equal and Traits::indices[iteration][d] == indices[d];
+    }
+    if (equal) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class T, class F, size_t... Is>
+constexpr T dense_entry(const F& f, std::true_type /*in_iteration_space*/) {
+  return f(std::integral_constant<size_t, Is>{}...);
+}
+
+template <class T, class F, size_t... Is>
+constexpr T dense_entry(const F& /*f*/,
+                        std::false_type /*in_iteration_space*/) {
+  return T{};
+}
+
+template <class Traits, class T, class F, size_t... Is>
+constexpr T make_dense_table_impl(const F& f,
+                                  std::index_sequence<Is...> /*indices*/,
+                                  std::index_sequence<> /*extents*/) {
+  return dense_entry<T, F, Is...>(
+      f, std::integral_constant<bool,
+                                in_iteration_space<Traits, Is...>()>{});
+}
+
+template <class Traits, class T, class F, size_t... Is, size_t Extent,
+          size_t... Extents, size_t... Rows>
+constexpr typename dense_table<T, Extent, Extents...>::type make_dense_rows(
+    const F& f, std::index_sequence<Is...> /*indices*/,
+    std::index_sequence<Extent, Extents...> /*extents*/,
+    std::index_sequence<Rows...> /*meta*/);
+
+template <class Traits, class T, class F, size_t... Is, size_t Extent,
+          size_t... Extents>
+constexpr typename dense_table<T, Extent, Extents...>::type
+make_dense_table_impl(const F& f, std::index_sequence<Is...> indices,
+                      std::index_sequence<Extent, Extents...> extents) {
+  return make_dense_rows<Traits, T>(f, indices, extents,
+                                    std::make_index_sequence<Extent>{});
+}
+
+template <class Traits, class T, class F, size_t... Is, size_t Extent,
+          size_t... Extents, size_t... Rows>
+constexpr typename dense_table<T, Extent, Extents...>::type make_dense_rows(
+    const F& f, std::index_sequence<Is...> /*indices*/,
+    std::index_sequence<Extent, Extents...> /*extents*/,
+    std::index_sequence<Rows...> /*meta*/) {
+  return {{make_dense_table_impl<Traits, T>(
+      f, std::index_sequence<Is..., Rows>{},
+      std::index_sequence<Extents...>{})...}};
+}
+
+template <class Traits, size_t... Ds>
+constexpr std::index_sequence<(Traits::max_index[Ds] + 1)...> dense_extents(
+    std::index_sequence<Ds...> /*meta*/) {
+  return {};
+}
+}  // namespace for_constexpr_detail
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Returns a `std::array` holding `f(i, j, ...)` for every iteration of
+ * `for_constexpr<Bounds...>`, in the order for_constexpr visits them.
+ *
+ * Like with for_constexpr, `f` is called with the loop indices as
+ * `std::integral_constant`s. If `f` is `constexpr` (any lambda in C++17) the
+ * table can be computed at compile time, so it is constant-initialized and
+ * costs nothing at startup. The loop indices of entry `n` are
+ * `for_constexpr_traits<Bounds...>::indices[n]`.
+ *
+ * \code
+ * constexpr auto triangle = make_table<for_bounds<0, 4>,
+ *                                      for_symm_lower<0, 0, 1>>(
+ *     [](auto i, auto j) { return i * (i + 1) / 2 + j; });
+ * \endcode
+ *
+ * \see make_dense_table for_constexpr for_constexpr_traits
+ */
+template <class... Bounds, class F>
+constexpr std::array<
+    for_constexpr_detail::table_value_t<for_constexpr_traits<Bounds...>, F>,
+    for_constexpr_traits<Bounds...>::iterations>
+make_table(const F& f) {
+  using traits = for_constexpr_traits<Bounds...>;
+  static_assert(traits::iterations > 0,
+                "Cannot make a table of an empty iteration space.");
+  return for_constexpr_detail::make_table_impl<traits>(
+      f, std::make_index_sequence<traits::iterations>{});
+}
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Returns nested `std::array`s `table` with `table[i][j]...` equal to
+ * `f(i, j, ...)` for every iteration of `for_constexpr<Bounds...>`, and
+ * value-initialized otherwise.
+ *
+ * The extent of each dimension is the largest value its loop index takes plus
+ * one, so for example a table over `for_bounds<0, N>, for_symm_lower<0, 0, 1>`
+ * is `N` by `N` with only its lower triangle evaluated. See make_table for the
+ * requirements on `f`.
+ *
+ * \see make_table for_constexpr
+ */
+template <class... Bounds, class F>
+constexpr auto make_dense_table(const F& f) {
+  using traits = for_constexpr_traits<Bounds...>;
+  static_assert(traits::iterations > 0,
+                "Cannot make a table of an empty iteration space.");
+  return for_constexpr_detail::make_dense_table_impl<
+      traits, for_constexpr_detail::table_value_t<traits, F>>(
+      f, std::index_sequence<>{},
+      for_constexpr_detail::dense_extents<traits>(
+          std::make_index_sequence<traits::depth>{}));
+}
+
+namespace for_constexpr_detail {
+// The value of loop `Level` at the flat index `Index` of the jump table, where
+// the last loop varies fastest
+template <size_t Index, size_t Level, class... Bounds>
+constexpr size_t dispatch_value() {
+  const size_t lowers[] = {Bounds::lower...};
+  const size_t extents[] = {(Bounds::upper - Bounds::lower)...};
+  size_t index = Index;
+  for (size_t level = sizeof...(Bounds) - 1; level > Level; --level) {
+    index /= extents[level];
+  }
+  return lowers[Level] + index % extents[Level];
+}
+
+template <class... Bounds>
+constexpr size_t dispatch_table_size() {
+  const size_t extents[] = {(Bounds::upper - Bounds::lower)...};
+  size_t size = 1;
+  for (const size_t extent : extents) {
+    size *= extent;
+  }
+  return size;
+}
+
+template <class R, class F, size_t Index, class... Bounds, size_t... Levels>
+R dispatch_call(F& f, std::index_sequence<Levels...> /*meta*/) {
+  return f(std::integral_constant<
+           size_t, dispatch_value<Index, Levels, Bounds...>()>{}...);
+}
+
+template <class R, class F, size_t Index, class... Bounds>
+R dispatch_entry(F& f) {
+  return dispatch_call<R, F, Index, Bounds...>(
+      f, std::make_index_sequence<sizeof...(Bounds)>{});
+}
+
+template <class R, class F, class... Bounds, size_t... Indices>
+R dispatch_jump(F& f, const size_t index,
+                std::index_sequence<Indices...> /*meta*/) {
+  static constexpr R (*const table[])(F&) = {
+      &dispatch_entry<R, F, Indices, Bounds...>...};
+  return table[index](f);
+}
+
+template <class... Bounds, class Args, size_t... Levels>
+decltype(auto) dispatch_bounds_impl(Args args,
+                                    std::index_sequence<Levels...> /*meta*/) {
+  auto& f = std::get<sizeof...(Levels)>(args);
+  using result_type =
+      decltype(f(std::integral_constant<size_t, Bounds::lower>{}...));
+  const size_t values[] = {static_cast<size_t>(std::get<Levels>(args))...};
+  const size_t lowers[] = {Bounds::lower...};
+  const size_t uppers[] = {Bounds::upper...};
+  size_t index = 0;
+  for (size_t level = 0; level < sizeof...(Levels); ++level) {
+    if (values[level] < lowers[level] or values[level] >= uppers[level]) {
+      throw std::out_of_range(
+          "dispatch_bounds: a runtime value is outside of its for_bounds");
+    }
+    index = index * (uppers[level] - lowers[level]) +
+            (values[level] - lowers[level]);
+  }
+  return dispatch_jump<result_type, std::remove_reference_t<decltype(f)>,
+                       Bounds...>(
+      f, index,
+      std::make_index_sequence<dispatch_table_size<Bounds...>()>{});
+}
+}  // namespace for_constexpr_detail
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Calls `f` with runtime sizes converted to `std::integral_constant`s,
+ * so that `f` can use them as for_constexpr bounds.
+ *
+ * Takes one runtime value per `for_bounds` followed by `f`, and calls
+ * `f(std::integral_constant<size_t, value>{}...)` through a jump table with an
+ * entry for every combination of values in the bounds. Every combination is
+ * thus compiled to its own fully unrolled path and dispatching costs a single
+ * indirect call. Throws `std::out_of_range` if a value is outside its bounds.
+ * Returns what `f` returns, which for all values must be convertible to what
+ * `f` returns at the lower bounds.
+ *
+ * \code
+ * double dot(const double* a, const double* b, const size_t dim) {
+ *   return dispatch_bounds<for_bounds<1, 4>>(dim, [a, b](auto n) {
+ *     double result = 0.0;
+ *     for_constexpr<for_bounds<0, decltype(n)::value>>(
+ *         [&result, a, b](auto i) { result += a[i] * b[i]; });
+ *     return result;
+ *   });
+ * }
+ * \endcode
+ *
+ * \see for_constexpr
+ */
+template <class... Bounds, class... Args>
+decltype(auto) dispatch_bounds(Args&&... args) {
+  static_assert(sizeof...(Bounds) > 0,
+                "dispatch_bounds needs at least one for_bounds");
+  static_assert(sizeof...(Args) == sizeof...(Bounds) + 1,
+                "Pass one runtime value per for_bounds followed by the "
+                "function to call");
+  static_assert(
+      for_constexpr_detail::all_true<
+          for_constexpr_detail::is_for_bounds<Bounds>::value...>::value,
+      "dispatch_bounds only supports for_bounds");
+  return for_constexpr_detail::dispatch_bounds_impl<Bounds...>(
+      std::forward_as_tuple(std::forward<Args>(args)...),
+      std::make_index_sequence<sizeof...(Bounds)>{});
+}
@@ -0,0 +1,412 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Benchmarks for_constexpr against the equivalent runtime nested for loops for
+ * loop nests of depth 1 to 4 with sizes 2 to 16. For each kernel the time per
+ * body invocation, the instructions retired per body invocation (Linux only,
+ * needs perf_event_paranoid <= 2), and the size of the kernel's machine code
+ * are printed.
+ *
+ * Kernels with more than `max_unrolled_iterations` body invocations (as
+ * computed by for_constexpr_traits) are only run as runtime loops, since fully
+ * unrolling them takes very long to compile and is well past the point where
+ * unrolling stops paying off. Even so, compiling takes a couple of minutes.
+ *
+ * Compile the code using:
+ * clang++ -std=c++17 -O3 ./for_constexpr_benchmark.cpp
+ * g++ -std=c++17 -O3 ./for_constexpr_benchmark.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "for_constexpr.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define NEVER_INLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NEVER_INLINE __declspec(noinline)
+#else
+#define NEVER_INLINE
+#endif
+
+// Used to find the address the executable was loaded at
+extern "C" NEVER_INLINE void for_constexpr_benchmark_anchor() {}
+
+namespace {
+constexpr size_t max_unrolled_iterations = 1024;
+constexpr size_t max_size = 16;
+double data[max_size * max_size * max_size * max_size];
+
+// Hand-written nested loops for the same bounds as for_constexpr, with the
+// loop at `Level` written out as a plain for loop.
+template <class... Bounds>
+struct runtime_loops {
+  template <size_t Level, class F, class... Indices>
+  ALWAYS_INLINE static void apply(F&& f, const Indices... indices) {
+    if constexpr (Level == sizeof...(Bounds)) {
+      f(indices...);
+    } else {
+      using bounds = std::tuple_element_t<Level, std::tuple<Bounds...>>;
+      const size_t values[sizeof...(Indices) + 1] = {indices..., 0};
+      for (size_t i = lower(bounds{}, values); i < upper(bounds{}, values);
+           ++i) {
+        apply<Level + 1>(f, indices..., i);
+      }
+    }
+  }
+
+ private:
+  template <size_t Lower, size_t Upper>
+  static constexpr size_t lower(for_bounds<Lower, Upper> /*meta*/,
+                                const size_t* /*values*/) {
+    return Lower;
+  }
+  template <size_t Lower, size_t Upper>
+  static constexpr size_t upper(for_bounds<Lower, Upper> /*meta*/,
+                                const size_t* /*values*/) {
+    return Upper;
+  }
+  template <size_t Index, size_t Lower, ssize_t Offset>
+  static constexpr size_t lower(for_symm_lower<Index, Lower, Offset> /*meta*/,
+                                const size_t* /*values*/) {
+    return Lower;
+  }
+  template <size_t Index, size_t Lower, ssize_t Offset>
+  static constexpr size_t upper(for_symm_lower<Index, Lower, Offset> /*meta*/,
+                                const size_t* values) {
+    return static_cast<size_t>(static_cast<ssize_t>(values[Index]) + Offset);
+  }
+  template <size_t Index, size_t Upper>
+  static constexpr size_t lower(for_symm_upper<Index, Upper> /*meta*/,
+                                const size_t* values) {
+    return values[Index];
+  }
+  template <size_t Index, size_t Upper>
+  static constexpr size_t upper(for_symm_upper<Index, Upper> /*meta*/,
+                                const size_t* /*values*/) {
+    return Upper;
+  }
+};
+
+template <size_t Size>
+struct body {
+  double* values;
+
+  template <class... Indices>
+  ALWAYS_INLINE void operator()(const Indices... indices) const {
+    size_t flat_index = 0;
+    static_cast<void>(std::initializer_list<char>{
+        (static_cast<void>(flat_index = flat_index * Size +
+                                        static_cast<size_t>(indices)),
+         '0')...});
+    values[flat_index] = values[flat_index] * 0.999 + 1.0;
+  }
+};
+
+template <size_t Size, class... Bounds>
+NEVER_INLINE void unrolled_kernel(double* const values) {
+  for_constexpr<Bounds...>(body<Size>{values});
+}
+
+template <size_t Size, class... Bounds>
+NEVER_INLINE void loop_kernel(double* const values) {
+  runtime_loops<Bounds...>::template apply<0>(body<Size>{values});
+}
+
+// Maps the addresses of the functions in this executable to their sizes using
+// the symbol table printed by nm.
+class function_sizes {
+ public:
+  function_sizes() {
+#ifdef __linux__
+    char executable[4096];
+    const ssize_t length =
+        readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+    if (length <= 0) {
+      return;
+    }
+    executable[length] = '\0';
+    const std::string command =
+        std::string("nm -S --defined-only '") + executable + "' 2>/dev/null";
+    const std::unique_ptr<FILE, int (*)(FILE*)> nm(popen(command.c_str(), "r"),
+                                                   pclose);
+    if (nm == nullptr) {
+      return;
+    }
+    char line[4096];
+    uintptr_t anchor_address = 0;
+    while (std::fgets(line, sizeof(line), nm.get()) != nullptr) {
+      unsigned long long address = 0;
+      unsigned long long size = 0;
+      char type = 0;
+      char name[4096];
+      if (std::sscanf(line, "%llx %llx %c %4095s", &address, &size, &type,
+                      name) != 4) {
+        continue;
+      }
+      sizes_[static_cast<uintptr_t>(address)] = static_cast<size_t>(size);
+      if (std::strcmp(name, "for_constexpr_benchmark_anchor") == 0) {
+        anchor_address = static_cast<uintptr_t>(address);
+      }
+    }
+    // Account for the executable being loaded at a different address
+    load_offset_ =
+        reinterpret_cast<uintptr_t>(&for_constexpr_benchmark_anchor) -
+        anchor_address;
+    valid_ = anchor_address != 0;
+#endif
+  }
+
+  bool valid() const { return valid_; }
+
+  // Returns 0 if the size is not known
+  size_t operator()(void (*f)(double*)) const {
+    if (not valid_) {
+      return 0;
+    }
+    const auto it = sizes_.find(reinterpret_cast<uintptr_t>(f) - load_offset_);
+    return it == sizes_.end() ? 0 : it->second;
+  }
+
+ private:
+  std::map<uintptr_t, size_t> sizes_{};
+  uintptr_t load_offset_ = 0;
+  bool valid_ = false;
+};
+
+// Counts the instructions retired by this thread
+class instruction_counter {
+ public:
+  instruction_counter() {
+#ifdef __linux__
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+  instruction_counter(const instruction_counter&) = delete;
+  instruction_counter& operator=(const instruction_counter&) = delete;
+  ~instruction_counter() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+#endif
+  }
+
+  bool valid() const { return fd_ >= 0; }
+
+  void start() {
+#ifdef __linux__
+    if (valid()) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  uint64_t stop() {
+    uint64_t count = 0;
+#ifdef __linux__
+    if (valid()) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+        count = 0;
+      }
+    }
+#endif
+    return count;
+  }
+
+ private:
+  int fd_ = -1;
+};
+
+struct measurement {
+  double ns_per_iteration;
+  double instructions_per_iteration;
+  size_t code_size;
+};
+
+measurement measure(void (*kernel)(double*), const size_t iterations,
+                    const function_sizes& sizes,
+                    instruction_counter& counter) {
+  // Repeat the kernel until enough time has passed for the clock to be
+  // accurate
+  size_t repetitions = 1;
+  double elapsed_ns = 0.0;
+  while (true) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      kernel(data);
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    elapsed_ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    if (elapsed_ns > 2.0e6) {
+      break;
+    }
+    repetitions *= 2;
+  }
+  counter.start();
+  for (size_t r = 0; r < repetitions; ++r) {
+    kernel(data);
+  }
+  const uint64_t instructions = counter.stop();
+  const double total_iterations =
+      static_cast<double>(repetitions) * static_cast<double>(iterations);
+  return {elapsed_ns / total_iterations,
+          static_cast<double>(instructions) / total_iterations,
+          sizes(kernel)};
+}
+
+struct kernel_pair {
+  const char* shape;
+  size_t size;
+  size_t depth;
+  size_t iterations;
+  void (*unrolled)(double*);
+  void (*loop)(double*);
+};
+
+template <size_t Size, class... Bounds>
+void add_kernels(std::vector<kernel_pair>& kernels, const char* const shape) {
+  using traits = for_constexpr_traits<Bounds...>;
+  void (*unrolled)(double*) = nullptr;
+  if constexpr (traits::iterations <= max_unrolled_iterations) {
+    unrolled = unrolled_kernel<Size, Bounds...>;
+  }
+  kernels.push_back({shape, Size, traits::depth, traits::iterations, unrolled,
+                     loop_kernel<Size, Bounds...>});
+}
+
+template <size_t N>
+void add_kernels_of_size(std::vector<kernel_pair>& kernels) {
+  using b = for_bounds<0, N>;
+  add_kernels<N, b>(kernels, "i");
+
+  add_kernels<N, b, b>(kernels, "i,j");
+  add_kernels<N, b, for_symm_lower<0, 0>>(kernels, "i,j<i");
+  add_kernels<N, b, for_symm_lower<0, 0, 1>>(kernels, "i,j<=i");
+  add_kernels<N, b, for_symm_upper<0, N>>(kernels, "i,j>=i");
+
+  add_kernels<N, b, b, b>(kernels, "i,j,k");
+  add_kernels<N, b, for_symm_lower<0, 0, 1>, for_symm_lower<1, 0, 1>>(
+      kernels, "i,j<=i,k<=j");
+  add_kernels<N, b, for_symm_upper<0, N>, for_symm_upper<1, N>>(
+      kernels, "i,j>=i,k>=j");
+  add_kernels<N, b, for_symm_lower<0, 0, 1>, for_symm_upper<1, N>>(
+      kernels, "i,j<=i,k>=j");
+  add_kernels<N, b, b, for_symm_lower<0, 0>>(kernels, "i,j,k<i");
+
+  add_kernels<N, b, b, b, b>(kernels, "i,j,k,l");
+  add_kernels<N, b, for_symm_lower<0, 0, 1>, for_symm_lower<1, 0, 1>,
+              for_symm_lower<2, 0, 1>>(kernels, "i,j<=i,k<=j,l<=k");
+  add_kernels<N, b, for_symm_upper<0, N>, for_symm_upper<1, N>,
+              for_symm_upper<2, N>>(kernels, "i,j>=i,k>=j,l>=k");
+  add_kernels<N, b, for_symm_lower<0, 0, 1>, b, for_symm_lower<2, 0, 1>>(
+      kernels, "i,j<=i,k,l<=k");
+}
+
+template <size_t... Sizes>
+std::vector<kernel_pair> all_kernels(std::index_sequence<Sizes...> /*meta*/) {
+  std::vector<kernel_pair> kernels{};
+  static_cast<void>(std::initializer_list<char>{
+      (add_kernels_of_size<Sizes + 2>(kernels), '0')...});
+  std::stable_sort(kernels.begin(), kernels.end(),
+                   [](const kernel_pair& a, const kernel_pair& b) {
+                     return a.depth < b.depth or
+                            (a.depth == b.depth and
+                             std::strcmp(a.shape, b.shape) < 0);
+                   });
+  return kernels;
+}
+}  // namespace
+
+int main() {
+  const function_sizes sizes{};
+  instruction_counter counter{};
+  std::fill(std::begin(data), std::end(data), 1.0);
+
+  std::printf("%-20s %4s %6s | %10s %10s %8s | %10s %10s %8s | %7s\n", "shape",
+              "size", "iters", "ns/iter", "instr/iter", "bytes", "ns/iter",
+              "instr/iter", "bytes", "speedup");
+  std::printf("%-32s | %-30s | %-30s |\n", "", "for_constexpr", "for loops");
+  for (const kernel_pair& kernels :
+       all_kernels(std::make_index_sequence<max_size - 1>{})) {
+    const measurement loop =
+        measure(kernels.loop, kernels.iterations, sizes, counter);
+    if (kernels.unrolled == nullptr) {
+      std::printf("%-20s %4zu %6zu | %-30s | %10.3f %10.2f %8zu |\n",
+                  kernels.shape, kernels.size, kernels.iterations,
+                  "not unrolled", loop.ns_per_iteration,
+                  loop.instructions_per_iteration, loop.code_size);
+      continue;
+    }
+    const measurement unrolled =
+        measure(kernels.unrolled, kernels.iterations, sizes, counter);
+    std::printf(
+        "%-20s %4zu %6zu | %10.3f %10.2f %8zu | %10.3f %10.2f %8zu | %7.2f\n",
+        kernels.shape, kernels.size, kernels.iterations,
+        unrolled.ns_per_iteration, unrolled.instructions_per_iteration,
+        unrolled.code_size, loop.ns_per_iteration,
+        loop.instructions_per_iteration, loop.code_size,
+        loop.ns_per_iteration / unrolled.ns_per_iteration);
+  }
+  if (not counter.valid()) {
+    std::printf("\nInstruction counts are not available (perf_event_open "
+                "failed)\n");
+  }
+  if (not sizes.valid()) {
+    std::printf("\nCode sizes are not available (nm failed)\n");
+  }
+}
@@ -0,0 +1,144 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+/*
+ * Prebuilt for_constexpr loop nests.
+ *
+ * Every call of for_constexpr with a new body instantiates the whole
+ * for_constexpr_impl recursion again, which adds up when many translation
+ * units loop over the same shapes. for_constexpr_prebuilt instead type-erases
+ * the body and calls a loop nest that is explicitly instantiated once in
+ * for_constexpr_library.cpp for the common shapes listed in
+ * `FOR_CONSTEXPR_LIBRARY_SHAPES`. Other shapes still work, but are
+ * instantiated in the translation unit that uses them.
+ *
+ * The body is called through a function pointer with the loop indices as
+ * `size_t`s, so unlike with for_constexpr the indices are not compile-time
+ * constants and the body is not inlined. Use for_constexpr in the few places
+ * where that matters and for_constexpr_prebuilt everywhere else.
+ *
+ * Link against for_constexpr_library.cpp:
+ * g++ -std=c++14 -O2 -c ./for_constexpr_library.cpp
+ * g++ -std=c++14 -O2 ./my_file.cpp ./for_constexpr_library.o
+ */
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "for_constexpr.hpp"
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief A for_constexpr loop nest over `Bounds...` that calls a type-erased
+ * body with a pointer to the `sizeof...(Bounds)` loop indices.
+ */
+template <class... Bounds>
+struct for_constexpr_shape {
+  using body_type = void (*)(void* context, const size_t* indices);
+
+  static void apply(body_type body, void* context);
+};
+
+template <class... Bounds>
+void for_constexpr_shape<Bounds...>::apply(const body_type body,
+                                           void* const context) {
+  for_constexpr<Bounds...>([body, context](auto... indices) {
+    const size_t values[sizeof...(indices)] = {indices...};
+    body(context, values);
+  });
+}
+
+// The shapes that are explicitly instantiated in for_constexpr_library.cpp:
+// for dimensions 1 to 3, loop nests of rank 1 to 4 that are rectangular,
+// lower symmetric (j <= i) or upper symmetric (j >= i) in each index.
+#define FOR_CONSTEXPR_LIBRARY_SHAPES_OF_DIM(SHAPE, DIM)                        \
+  SHAPE(for_bounds<0, DIM>)                                                    \
+  SHAPE(for_bounds<0, DIM>, for_bounds<0, DIM>)                                \
+  SHAPE(for_bounds<0, DIM>, for_symm_lower<0, 0, 1>)                           \
+  SHAPE(for_bounds<0, DIM>, for_symm_upper<0, DIM>)                            \
+  SHAPE(for_bounds<0, DIM>, for_bounds<0, DIM>, for_bounds<0, DIM>)            \
+  SHAPE(for_bounds<0, DIM>, for_symm_lower<0, 0, 1>, for_symm_lower<1, 0, 1>)  \
+  SHAPE(for_bounds<0, DIM>, for_symm_upper<0, DIM>, for_symm_upper<1, DIM>)    \
+  SHAPE(for_bounds<0, DIM>, for_bounds<0, DIM>, for_symm_lower<1, 0, 1>)       \
+  SHAPE(for_bounds<0, DIM>, for_bounds<0, DIM>, for_bounds<0, DIM>,            \
+        for_bounds<0, DIM>)                                                    \
+  SHAPE(for_bounds<0, DIM>, for_symm_lower<0, 0, 1>, for_symm_lower<1, 0, 1>,  \
+        for_symm_lower<2, 0, 1>)                                               \
+  SHAPE(for_bounds<0, DIM>, for_symm_upper<0, DIM>, for_symm_upper<1, DIM>,    \
+        for_symm_upper<2, DIM>)                                                \
+  SHAPE(for_bounds<0, DIM>, for_symm_lower<0, 0, 1>, for_bounds<0, DIM>,       \
+        for_symm_lower<2, 0, 1>)
+
+#define FOR_CONSTEXPR_LIBRARY_SHAPES(SHAPE)   \
+  FOR_CONSTEXPR_LIBRARY_SHAPES_OF_DIM(SHAPE, 1) \
+  FOR_CONSTEXPR_LIBRARY_SHAPES_OF_DIM(SHAPE, 2) \
+  FOR_CONSTEXPR_LIBRARY_SHAPES_OF_DIM(SHAPE, 3)
+
+#define FOR_CONSTEXPR_LIBRARY_EXTERN_SHAPE(...) \
+  extern template struct for_constexpr_shape<__VA_ARGS__>;
+FOR_CONSTEXPR_LIBRARY_SHAPES(FOR_CONSTEXPR_LIBRARY_EXTERN_SHAPE)
+#undef FOR_CONSTEXPR_LIBRARY_EXTERN_SHAPE
+
+namespace for_constexpr_library_detail {
+template <class F, size_t... Is>
+ALWAYS_INLINE void call_with_indices(F& f, const size_t* const indices,
+                                     std::index_sequence<Is...> /*meta*/) {
+  f(indices[Is]...);
+}
+}  // namespace for_constexpr_library_detail
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Calls `f(i, j, ...)` with `size_t` loop indices for every iteration
+ * of the loop nest `for_constexpr<Bounds...>`, using the prebuilt loop nest
+ * from for_constexpr_library.cpp if there is one.
+ *
+ * \example
+ * \code
+ * for_constexpr_prebuilt<for_bounds<0, 3>, for_symm_lower<0, 0, 1>>(
+ *     [&values](size_t i, size_t j) { values[i][j]++; });
+ * \endcode
+ *
+ * \see for_constexpr for_constexpr_shape
+ */
+template <class... Bounds, class F>
+void for_constexpr_prebuilt(F&& f) {
+  using body = std::remove_reference_t<F>;
+  for_constexpr_shape<Bounds...>::apply(
+      [](void* const context, const size_t* const indices) {
+        for_constexpr_library_detail::call_with_indices(
+            *static_cast<body*>(context), indices,
+            std::make_index_sequence<sizeof...(Bounds)>{});
+      },
+      const_cast<void*>(static_cast<const void*>(std::addressof(f))));
+}
@@ -0,0 +1,119 @@
+#!/bin/sh
+# Copyright 2017 Nils Deppe
+# Distributed under the Boost Software License, Version 1.0.
+# (See accompanying file LICENSE or copy at http://boost.org/LICENSE_1_0.txt)
+#
+# Measures how much build time for_constexpr_library saves. Generates a
+# synthetic project of $TRANSLATION_UNITS (default: 100) translation units that
+# each loop over common shapes with a dozen different bodies, and compiles it
+# once calling for_constexpr directly and once calling for_constexpr_prebuilt,
+# including compiling for_constexpr_library.cpp, and prints both times.
+#
+# Usage:
+# ./for_constexpr_library_build_time.sh
+# CXX=clang++ CXXFLAGS="-O3" TRANSLATION_UNITS=20 \
+#   ./for_constexpr_library_build_time.sh
+
+set -u
+
+cd "$(dirname "$0")" || exit 1
+
+cxx=${CXX:-g++}
+cxxflags=${CXXFLAGS:-"-O2"}
+translation_units=${TRANSLATION_UNITS:-100}
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+
+# Writes a translation unit whose loops use the macro LOOP, which is either
+# for_constexpr or for_constexpr_prebuilt.
+generate() {
+  cat <<CPP
+#include "for_constexpr_library.hpp"
+
+#ifdef USE_PREBUILT
+#define LOOP(...) for_constexpr_prebuilt<__VA_ARGS__>
+#else
+#define LOOP(...) for_constexpr<__VA_ARGS__>
+#endif
+
+double kernel_$1(const double* v) {
+  double sum = 0.0;
+  LOOP(for_bounds<0, 3>)([&sum, v](auto i) { sum += v[i] * $1; });
+  LOOP(for_bounds<0, 3>, for_bounds<0, 3>)(
+      [&sum, v](auto i, auto j) { sum += v[3 * i + j] * $1; });
+  LOOP(for_bounds<0, 3>, for_symm_lower<0, 0, 1>)(
+      [&sum, v](auto i, auto j) { sum -= v[3 * i + j] * $1; });
+  LOOP(for_bounds<0, 2>, for_symm_upper<0, 2>)(
+      [&sum, v](auto i, auto j) { sum += v[2 * i + j] + $1; });
+  LOOP(for_bounds<0, 3>, for_bounds<0, 3>, for_bounds<0, 3>)(
+      [&sum, v](auto i, auto j, auto k) { sum += v[9 * i + 3 * j + k]; });
+  LOOP(for_bounds<0, 3>, for_symm_lower<0, 0, 1>, for_symm_lower<1, 0, 1>)(
+      [&sum, v](auto i, auto j, auto k) { sum *= v[i + j + k]; });
+  LOOP(for_bounds<0, 3>, for_bounds<0, 3>, for_symm_lower<1, 0, 1>)(
+      [&sum, v](auto i, auto j, auto k) { sum += v[i * j + k] * $1; });
+  LOOP(for_bounds<0, 2>, for_symm_upper<0, 2>, for_symm_upper<1, 2>)(
+      [&sum, v](auto i, auto j, auto k) { sum -= v[i + j * k]; });
+  LOOP(for_bounds<0, 3>, for_bounds<0, 3>, for_bounds<0, 3>,
+       for_bounds<0, 3>)([&sum, v](auto i, auto j, auto k, auto l) {
+    sum += v[27 * i + 9 * j + 3 * k + l] * $1;
+  });
+  LOOP(for_bounds<0, 3>, for_symm_lower<0, 0, 1>, for_symm_lower<1, 0, 1>,
+       for_symm_lower<2, 0, 1>)([&sum, v](auto i, auto j, auto k, auto l) {
+    sum += v[i + j + k + l];
+  });
+  LOOP(for_bounds<0, 3>, for_symm_lower<0, 0, 1>, for_bounds<0, 3>,
+       for_symm_lower<2, 0, 1>)([&sum, v](auto i, auto j, auto k, auto l) {
+    sum -= v[i * j + k * l] * $1;
+  });
+  LOOP(for_bounds<0, 2>, for_bounds<0, 2>, for_bounds<0, 2>,
+       for_bounds<0, 2>)([&sum, v](auto i, auto j, auto k, auto l) {
+    sum += v[8 * i + 4 * j + 2 * k + l] + $1;
+  });
+  return sum;
+}
+CPP
+}
+
+i=0
+while [ "$i" -lt "$translation_units" ]; do
+  generate "$i" > "$work_dir/tu_$i.cpp"
+  i=$((i + 1))
+done
+
+now() {
+  date +%s.%N
+}
+
+# Compiles every translation unit with the extra flags $1 and prints the
+# elapsed seconds.
+build() {
+  start=$(now)
+  i=0
+  while [ "$i" -lt "$translation_units" ]; do
+    # shellcheck disable=SC2086
+    if ! "$cxx" -std=c++14 $cxxflags $1 -I. -c "$work_dir/tu_$i.cpp" \
+      -o "$work_dir/tu_$i.o"; then
+      echo "FAIL: compiling tu_$i.cpp with $1" >&2
+      exit 1
+    fi
+    i=$((i + 1))
+  done
+  if [ -n "$2" ]; then
+    # shellcheck disable=SC2086
+    if ! "$cxx" -std=c++14 $cxxflags -c "$2" -o "$work_dir/library.o"; then
+      echo "FAIL: compiling $2" >&2
+      exit 1
+    fi
+  fi
+  echo "$start $(now)" | awk '{ printf "%.2f", $2 - $1 }'
+}
+
+direct=$(build "" "") || exit 1
+prebuilt=$(build "-DUSE_PREBUILT" "for_constexpr_library.cpp") || exit 1
+
+echo "$cxx $cxxflags, $translation_units translation units:"
+echo "  for_constexpr:          ${direct}s"
+echo "  for_constexpr_prebuilt: ${prebuilt}s (including the library)"
+echo "$direct $prebuilt" |
+  awk '{ printf "  reduction:              %.1f%%\n", 100 * (1 - $2 / $1) }'
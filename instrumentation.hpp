@@ -0,0 +1,266 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+/*
+ * Opt-in instrumentation of the tuple and loop utilities.
+ *
+ * The utilities are `ALWAYS_INLINE` and so do not show up in profiles. When
+ * `TMPL_INSTRUMENT` is defined before including any of the headers, every call
+ * site of for_constexpr, tuple_fold, tuple_counted_fold and tuple_transform
+ * records how often it was called, the total cycles spent in it, and the
+ * number of calls and cycles spent on each element (or innermost loop index).
+ * A call site is identified by the type of the function object passed to it,
+ * which for lambdas is unique to the call site. The counters are kept in a
+ * table per thread so recording does not need locks or atomic
+ * read-modify-writes. A summary is written to `stderr` at exit.
+ *
+ * When `TMPL_INSTRUMENT` is not defined the macros below expand to nothing (or
+ * to the expression being timed), so the generated code is unchanged.
+ *
+ * \note With instrumentation enabled the utilities can no longer be used in
+ * constant expressions.
+ */
+
+#ifdef TMPL_INSTRUMENT
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace instrumentation {
+constexpr size_t max_call_sites = 1024;
+// Elements with larger indices are accumulated in the last slot
+constexpr size_t max_elements = 32;
+
+// Tags used to distinguish the different utilities in the call site name
+struct for_constexpr_site;
+struct tuple_fold_site;
+struct tuple_counted_fold_site;
+struct tuple_transform_site;
+
+template <class Kind, class... Ts>
+struct call_site_tag {};
+
+inline uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+struct counter {
+  std::atomic<uint64_t> value{0};
+
+  // Only the owning thread writes to a counter, so a relaxed load and store
+  // suffice and are much cheaper than a fetch_add.
+  void add(const uint64_t v) {
+    value.store(value.load(std::memory_order_relaxed) + v,
+                std::memory_order_relaxed);
+  }
+  uint64_t get() const { return value.load(std::memory_order_relaxed); }
+};
+
+struct call_site_counters {
+  counter calls;
+  counter cycles;
+  std::array<counter, max_elements> element_calls;
+  std::array<counter, max_elements> element_cycles;
+};
+
+using thread_table = std::array<call_site_counters, max_call_sites>;
+
+struct registry {
+  std::mutex mutex;
+  std::vector<const char*> names;
+  // Tables are never freed so that the counts of threads that have exited
+  // are still available when dumping.
+  std::vector<const thread_table*> tables;
+};
+
+inline registry& get_registry() {
+  static registry r{};
+  return r;
+}
+
+inline void dump() {
+  registry& r = get_registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::fprintf(stderr, "\n%-8s %14s %14s %12s  %s\n", "site", "calls",
+               "cycles", "cycles/call", "name");
+  for (size_t site = 0; site < r.names.size(); ++site) {
+    uint64_t calls = 0;
+    uint64_t cycles = 0;
+    std::array<uint64_t, max_elements> element_calls{};
+    std::array<uint64_t, max_elements> element_cycles{};
+    for (const thread_table* table : r.tables) {
+      const call_site_counters& counters = (*table)[site];
+      calls += counters.calls.get();
+      cycles += counters.cycles.get();
+      for (size_t i = 0; i < max_elements; ++i) {
+        element_calls[i] += counters.element_calls[i].get();
+        element_cycles[i] += counters.element_cycles[i].get();
+      }
+    }
+    if (calls == 0) {
+      continue;
+    }
+    // Drop the closing bracket of the pretty function name
+    const size_t name_length = std::strlen(r.names[site]);
+    std::fprintf(stderr, "%-8zu %14llu %14llu %12.1f  %.*s\n", site,
+                 static_cast<unsigned long long>(calls),
+                 static_cast<unsigned long long>(cycles),
+                 static_cast<double>(cycles) / static_cast<double>(calls),
+                 static_cast<int>(name_length > 0 and
+                                          r.names[site][name_length - 1] == ']'
+                                      ? name_length - 1
+                                      : name_length),
+                 r.names[site]);
+    for (size_t i = 0; i < max_elements; ++i) {
+      if (element_calls[i] != 0) {
+        std::fprintf(stderr, "  element %2zu%s %10llu calls %12.1f cycles/call\n",
+                     i, i + 1 == max_elements ? "+" : " ",
+                     static_cast<unsigned long long>(element_calls[i]),
+                     static_cast<double>(element_cycles[i]) /
+                         static_cast<double>(element_calls[i]));
+      }
+    }
+  }
+}
+
+inline size_t register_call_site(const char* name) {
+  // Only keep the tag from the pretty function name
+  const char* const tag = std::strstr(name, "Tag = ");
+  if (tag != nullptr) {
+    name = tag + 6;
+  }
+  registry& r = get_registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  if (r.names.empty()) {
+    std::atexit(dump);
+  }
+  if (r.names.size() == max_call_sites) {
+    return max_call_sites - 1;
+  }
+  r.names.push_back(name);
+  return r.names.size() - 1;
+}
+
+inline thread_table& this_thread_table() {
+  thread_local thread_table* const table = [] {
+    auto* const t = new thread_table{};
+    registry& r = get_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.tables.push_back(t);
+    return t;
+  }();
+  return *table;
+}
+
+template <class Tag>
+const char* call_site_name() {
+#if defined(_MSC_VER)
+  return __FUNCSIG__;
+#else
+  return __PRETTY_FUNCTION__;
+#endif
+}
+
+template <class Tag>
+struct call_site {
+  static const size_t id;
+};
+
+template <class Tag>
+const size_t call_site<Tag>::id = register_call_site(call_site_name<Tag>());
+
+// Records one call of the call site `Tag` lasting the lifetime of the object
+template <class Tag>
+class scoped_call {
+ public:
+  scoped_call() : start_(read_cycles()) {}
+  scoped_call(const scoped_call&) = delete;
+  scoped_call& operator=(const scoped_call&) = delete;
+  ~scoped_call() {
+    const uint64_t stop = read_cycles();
+    call_site_counters& counters = this_thread_table()[call_site<Tag>::id];
+    counters.calls.add(1);
+    counters.cycles.add(stop - start_);
+  }
+
+ private:
+  uint64_t start_;
+};
+
+template <class Tag, class F>
+decltype(auto) time_element(const size_t index, F&& f) {
+  struct element_timer {
+    size_t index;
+    uint64_t start;
+    ~element_timer() {
+      const uint64_t stop = read_cycles();
+      call_site_counters& counters = this_thread_table()[call_site<Tag>::id];
+      const size_t slot = index < max_elements ? index : max_elements - 1;
+      counters.element_calls[slot].add(1);
+      counters.element_cycles[slot].add(stop - start);
+    }
+  } timer{index, read_cycles()};
+  return f();
+}
+}  // namespace instrumentation
+
+#define TMPL_INSTRUMENT_TAG(...) using tmpl_instrument_tag = __VA_ARGS__
+#define TMPL_INSTRUMENT_CALL()                                   \
+  const ::instrumentation::scoped_call<tmpl_instrument_tag>      \
+      tmpl_instrument_call {}
+#define TMPL_INSTRUMENT_ELEMENT(index, ...)                                \
+  ::instrumentation::time_element<tmpl_instrument_tag>(                    \
+      index, [&]() -> decltype(auto) { return __VA_ARGS__; })
+
+#else  // TMPL_INSTRUMENT
+
+#define TMPL_INSTRUMENT_TAG(...)
+#define TMPL_INSTRUMENT_CALL()
+#define TMPL_INSTRUMENT_ELEMENT(index, ...) __VA_ARGS__
+
+#endif  // TMPL_INSTRUMENT
@@ -0,0 +1,129 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compile the code using:
+ * clang++ -std=c++17 ./lazy-tuple.cpp
+ * g++ -std=c++17 ./lazy-tuple.cpp
+ */
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <string>
+#include <tuple>
+
+#include "lazy_tuple.hpp"
+
+namespace {
+void lazy_tuple_example() {
+  std::array<size_t, 3> calls{};
+  const auto tuple = make_lazy_tuple(
+      [&calls]() {
+        calls[0]++;
+        return 1.5;
+      },
+      [&calls]() {
+        calls[1]++;
+        return std::string("two");
+      },
+      [&calls]() {
+        calls[2]++;
+        return 3;
+      });
+  static_assert(std::tuple_size<std::decay_t<decltype(tuple)>>::value == 3,
+                "");
+  static_assert(
+      std::is_same<std::tuple_element_t<1, std::decay_t<decltype(tuple)>>,
+                   std::string>::value,
+      "");
+
+  // Only the accessed element is computed, and only once
+  assert(get<1>(tuple) == "two");
+  assert(get<1>(tuple) == "two");
+  assert((calls == std::array<size_t, 3>{{0, 1, 0}}));
+  assert(not tuple.is_computed<0>() and tuple.is_computed<1>());
+
+  // Folds compute the remaining elements when they reach them
+  size_t count = 0;
+  tuple_counted_fold(tuple,
+                     [](const auto& /*element*/, const size_t index,
+                        size_t& state) { state += index; },
+                     count);
+  assert(count == 3);
+  assert((calls == std::array<size_t, 3>{{1, 1, 1}}));
+}
+
+void transform_view_example() {
+  size_t calls = 0;
+  const auto tuple = make_lazy_tuple(
+      [&calls]() {
+        calls++;
+        return 2;
+      },
+      [&calls]() {
+        calls++;
+        return 3.5;
+      });
+
+  // Views compose without computing or storing anything
+  size_t squares = 0;
+  const auto squared =
+      make_transform_view(tuple, [&squares](const auto& element, auto /*i*/) {
+        squares++;
+        return element * element;
+      });
+  const auto negated = make_transform_view(
+      squared, [](const auto& element, auto /*i*/) { return -element; });
+  assert(calls == 0 and squares == 0);
+
+  assert(get<1>(negated) == -12.25);
+  assert(calls == 1 and squares == 1);
+
+  double sum = 0.0;
+  tuple_fold(
+      negated, [](const auto& element, double& state) { state += element; },
+      sum);
+  assert(sum == -16.25);
+  // The lazy tuple computed each element once, the views compute them on
+  // every access
+  assert(calls == 2 and squares == 3);
+
+  // Views of plain tuples, passing the index as an integral_constant
+  const auto indexed = make_transform_view(
+      std::make_tuple(10, 20, 30),
+      [](const int element, auto i) { return element + decltype(i)::value; });
+  assert(get<2>(indexed) == 32);
+}
+}  // namespace
+
+int main() {
+  lazy_tuple_example();
+  transform_view_example();
+}
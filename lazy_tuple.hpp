@@ -0,0 +1,185 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "tuple_fold.hpp"
+
+/*!
+ * \brief A tuple whose element `I` is computed by calling the `I`th function
+ * the first time it is accessed, and stored for later accesses.
+ *
+ * Elements are accessed with `get<I>(tuple)`, which returns a const reference
+ * to the stored value. tuple_fold and tuple_counted_fold accept lazy tuples and
+ * compute each element when they reach it. Elements that are never accessed
+ * are never computed. Accessing the elements of the same lazy_tuple from
+ * multiple threads at once is not safe.
+ *
+ * \code
+ * const auto tuple = make_lazy_tuple([]() { return expensive_a(); },
+ *                                    []() { return expensive_b(); });
+ * use(get<1>(tuple));  // only computes expensive_b()
+ * \endcode
+ *
+ * \see make_lazy_tuple make_transform_view
+ */
+template <class... Fs>
+class lazy_tuple {
+ public:
+  explicit lazy_tuple(Fs... functions) : functions_(std::move(functions)...) {}
+
+  template <size_t I>
+  const auto& get() const {
+    auto& value = std::get<I>(values_);
+    if (not value) {
+      value.emplace(std::get<I>(functions_)());
+    }
+    return *value;
+  }
+
+  template <size_t I>
+  bool is_computed() const {
+    return std::get<I>(values_).has_value();
+  }
+
+ private:
+  std::tuple<Fs...> functions_;
+  mutable std::tuple<
+      std::optional<std::decay_t<std::invoke_result_t<const Fs&>>>...>
+      values_;
+};
+
+template <class... Fs>
+lazy_tuple<std::decay_t<Fs>...> make_lazy_tuple(Fs&&... functions) {
+  return lazy_tuple<std::decay_t<Fs>...>(std::forward<Fs>(functions)...);
+}
+
+template <size_t I, class... Fs>
+const auto& get(const lazy_tuple<Fs...>& tuple) {
+  return tuple.template get<I>();
+}
+
+/*!
+ * \brief A view of `Base`, a `std::tuple`, lazy_tuple, or another
+ * tuple_transform_view, whose element `I` is `op(get<I>(base),
+ * std::integral_constant<size_t, I>{})`.
+ *
+ * The op takes the same arguments as in tuple_transform. Elements are computed
+ * every time they are accessed and never stored, so views can be composed
+ * without materializing any intermediate tuples. The view holds a reference to
+ * `Base` if it was constructed from an lvalue.
+ *
+ * \see make_transform_view lazy_tuple
+ */
+template <class Base, class Op>
+class tuple_transform_view {
+ public:
+  tuple_transform_view(Base base, Op op)
+      : base_(std::forward<Base>(base)), op_(std::move(op)) {}
+
+  template <size_t I>
+  decltype(auto) get() const {
+    using std::get;
+    return op_(get<I>(base_), std::integral_constant<size_t, I>{});
+  }
+
+ private:
+  Base base_;
+  Op op_;
+};
+
+template <class Base, class Op>
+tuple_transform_view<Base, std::decay_t<Op>> make_transform_view(Base&& base,
+                                                                 Op&& op) {
+  return {std::forward<Base>(base), std::forward<Op>(op)};
+}
+
+template <size_t I, class Base, class Op>
+decltype(auto) get(const tuple_transform_view<Base, Op>& view) {
+  return view.template get<I>();
+}
+
+namespace std {
+template <class... Fs>
+struct tuple_size<lazy_tuple<Fs...>>
+    : std::integral_constant<size_t, sizeof...(Fs)> {};
+
+template <size_t I, class... Fs>
+struct tuple_element<I, lazy_tuple<Fs...>> {
+  using type = std::decay_t<decltype(
+      std::declval<const lazy_tuple<Fs...>&>().template get<I>())>;
+};
+
+template <class Base, class Op>
+struct tuple_size<tuple_transform_view<Base, Op>>
+    : tuple_size<std::decay_t<Base>> {};
+
+template <size_t I, class Base, class Op>
+struct tuple_element<I, tuple_transform_view<Base, Op>> {
+  using type = std::decay_t<decltype(
+      std::declval<const tuple_transform_view<Base, Op>&>().template get<I>())>;
+};
+}  // namespace std
+
+namespace tuple_impl_detail {
+template <class T>
+struct is_lazy_tuple : std::false_type {};
+
+template <class... Fs>
+struct is_lazy_tuple<lazy_tuple<Fs...>> : std::true_type {};
+
+template <class Base, class Op>
+struct is_lazy_tuple<tuple_transform_view<Base, Op>> : std::true_type {};
+}  // namespace tuple_impl_detail
+
+template <bool ReverseIteration = false, typename LazyTuple, typename N_aryOp,
+          typename... Args,
+          std::enable_if_t<tuple_impl_detail::is_lazy_tuple<LazyTuple>::value,
+                           int> = 0>
+void tuple_fold(const LazyTuple& tuple, N_aryOp&& op, Args&&... args) {
+  tuple_impl_detail::tuple_fold_impl<ReverseIteration>(
+      tuple, std::forward<N_aryOp>(op),
+      std::make_index_sequence<std::tuple_size<LazyTuple>::value>{}, args...);
+}
+
+template <bool ReverseIteration = false, typename LazyTuple, typename N_aryOp,
+          typename... Args,
+          std::enable_if_t<tuple_impl_detail::is_lazy_tuple<LazyTuple>::value,
+                           int> = 0>
+void tuple_counted_fold(const LazyTuple& tuple, N_aryOp&& op, Args&&... args) {
+  tuple_impl_detail::tuple_counted_fold_impl<ReverseIteration>(
+      tuple, std::forward<N_aryOp>(op),
+      std::make_index_sequence<std::tuple_size<LazyTuple>::value>{}, args...);
+}
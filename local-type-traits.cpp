@@ -33,8 +33,11 @@ DEALINGS IN THE SOFTWARE.
  * g++ -std=c++14 ./overloaded-lambda.cpp
  */
 
+#include <cassert>
+#include <cstddef>
 #include <iostream>
 #include <map>
+#include <string>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
@@ -198,6 +201,146 @@ void local_type_trait_example2() {
   std::cout << "Is a map: " << decltype(is_std_map(d, 0))::value << "\n";
 }
 
+template <class T>
+struct span {
+  constexpr span(T* data, size_t size) : data_(data), size_(size) {}
+  template <class Container>
+  constexpr explicit span(Container& c) : data_(c.data()), size_(c.size()) {}
+
+  constexpr T* begin() const { return data_; }
+  constexpr T* end() const { return data_ + size_; }
+  constexpr size_t size() const { return size_; }
+  constexpr T& operator[](size_t i) const { return data_[i]; }
+
+ private:
+  T* data_;
+  size_t size_;
+};
+
+// Each type records which of its member functions batched_apply called
+struct my_batch_type0 {
+  std::string dispatched{};
+
+  int func(int a) {
+    dispatched = "func";
+    return 2 * a;
+  }
+};
+
+struct my_batch_type1 {
+  std::string dispatched{};
+
+  int func(int a) {
+    dispatched = "func";
+    return 2 * a;
+  }
+
+  std::vector<int> func_batch(span<const int> in) {
+    dispatched = "func_batch";
+    std::vector<int> result(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+      result[i] = 2 * in[i];
+    }
+    return result;
+  }
+};
+
+struct my_batch_type2 {
+  std::string dispatched{};
+
+  int func(int a) {
+    dispatched = "func";
+    return 2 * a;
+  }
+
+  void func(span<const int> in, span<int> out) {
+    dispatched = "func(span, span)";
+    for (size_t i = 0; i < in.size(); ++i) {
+      out[i] = 2 * in[i];
+    }
+  }
+};
+
+// Only has the bulk member function
+struct my_batch_type3 {
+  std::string dispatched{};
+
+  std::vector<int> func_batch(span<const int> in) {
+    dispatched = "func_batch";
+    std::vector<int> result(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+      result[i] = 2 * in[i];
+    }
+    return result;
+  }
+};
+
+/*
+ * Applies `obj.func` to every element of `inputs`, using the bulk member
+ * function of `T` if it has one. In order of preference this calls
+ * `obj.func_batch(inputs)`, `obj.func(inputs, out)`, or `obj.func(input)` for
+ * each element. The choice is made at compile time using local type traits.
+ */
+template <class T, class U>
+auto batched_apply(T& obj, span<const U> inputs) {
+  constexpr auto has_func_batch_impl = make_overloader(
+      [](auto t, int) -> decltype(
+          (void)std::declval<decltype(t)&>().func_batch(
+              std::declval<span<const U>>()),
+          std::true_type{}) { return std::true_type{}; },
+      [](auto...) { return std::false_type{}; });
+  using has_func_batch = decltype(has_func_batch_impl);
+
+  // The output span holds the result type of the per-element `func`
+  constexpr auto has_func_span_impl = make_overloader(
+      [](auto t, int) -> decltype(
+          (void)std::declval<decltype(t)&>().func(
+              std::declval<span<const U>>(),
+              std::declval<span<decltype(std::declval<decltype(t)&>().func(
+                  std::declval<U>()))>>()),
+          std::true_type{}) { return std::true_type{}; },
+      [](auto...) { return std::false_type{}; });
+  using has_func_span = decltype(has_func_span_impl);
+
+  const auto apply = make_overloader(
+      [](auto& o, span<const U> in, std::true_type /*meta*/, auto /*meta*/) {
+        return o.func_batch(in);
+      },
+      [](auto& o, span<const U> in, std::false_type /*meta*/,
+         std::true_type /*meta*/) {
+        using result_type = decltype(o.func(in[0]));
+        std::vector<result_type> result(in.size());
+        o.func(in, span<result_type>(result));
+        return result;
+      },
+      [](auto& o, span<const U> in, std::false_type /*meta*/,
+         std::false_type /*meta*/) {
+        using result_type = decltype(o.func(in[0]));
+        std::vector<result_type> result(in.size());
+        for (size_t i = 0; i < in.size(); ++i) {
+          result[i] = o.func(in[i]);
+        }
+        return result;
+      });
+  return apply(
+      obj, inputs,
+      std::integral_constant<bool, local_trait_v<has_func_batch, T>>{},
+      std::integral_constant<bool, local_trait_v<has_func_span, T>>{});
+}
+
+template <class T>
+void batched_apply_example(T t, const std::string& expected_dispatch) {
+  const std::vector<int> inputs{1, 2, 3, 4};
+  const auto result = batched_apply(t, span<const int>(inputs));
+  assert(t.dispatched == expected_dispatch);
+  assert((result == std::vector<int>{2, 4, 6, 8}));
+  std::cout << "Result using " << t.dispatched << ":";
+  for (const auto& r : result) {
+    std::cout << " " << r;
+  }
+  std::cout << "\n";
+}
+
 int main() {
   std::cout << "\n";
   const auto lambdas = make_overloader(
@@ -220,4 +363,10 @@ int main() {
 
   std::cout << "\n";
   local_type_trait_example2();
+
+  std::cout << "\n";
+  batched_apply_example(my_batch_type0{}, "func");
+  batched_apply_example(my_batch_type1{}, "func_batch");
+  batched_apply_example(my_batch_type2{}, "func(span, span)");
+  batched_apply_example(my_batch_type3{}, "func_batch");
 }
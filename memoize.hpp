@@ -0,0 +1,319 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "tuple_hash.hpp"
+
+/*!
+ * \brief Counters of a memoized function.
+ *
+ * `compute_ns` is the total time spent calling the function on misses, so
+ * `hits * mean_compute_ns()` estimates the time the cache saved.
+ */
+struct memoize_stats {
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t evictions = 0;
+  double compute_ns = 0.0;
+
+  double hit_rate() const {
+    return hits + misses == 0 ? 0.0
+                              : static_cast<double>(hits) /
+                                    static_cast<double>(hits + misses);
+  }
+
+  double mean_compute_ns() const {
+    return misses == 0 ? 0.0 : compute_ns / static_cast<double>(misses);
+  }
+};
+
+/// Mode of memoize for a function only called from one thread at a time
+struct memoize_single_threaded {
+  static constexpr size_t shards = 1;
+  struct mutex {
+    void lock() {}
+    void unlock() {}
+  };
+};
+
+/// Mode of memoize for a function called from several threads at once. The
+/// cache is split into `Shards` parts, each with its own lock.
+template <size_t Shards>
+struct memoize_sharded {
+  static_assert(Shards > 0, "A sharded cache needs at least one shard");
+  static constexpr size_t shards = Shards;
+  using mutex = std::mutex;
+};
+
+namespace memoize_detail {
+// The argument and result types of a function pointer or of a class with a
+// single, non-template call operator
+template <class F>
+struct signature : signature<decltype(&F::operator())> {};
+
+template <class R, class... Args>
+struct signature<R (*)(Args...)> {
+  using key_type = std::tuple<std::decay_t<Args>...>;
+  using result_type = std::decay_t<R>;
+};
+
+template <class R, class... Args>
+struct signature<R (*)(Args...) noexcept> : signature<R (*)(Args...)> {};
+
+template <class R, class C, class... Args>
+struct signature<R (C::*)(Args...)> : signature<R (*)(Args...)> {};
+
+template <class R, class C, class... Args>
+struct signature<R (C::*)(Args...) const> : signature<R (*)(Args...)> {};
+
+template <class R, class C, class... Args>
+struct signature<R (C::*)(Args...) noexcept> : signature<R (*)(Args...)> {};
+
+template <class R, class C, class... Args>
+struct signature<R (C::*)(Args...) const noexcept>
+    : signature<R (*)(Args...)> {};
+
+constexpr size_t next_power_of_two(const size_t n) {
+  size_t result = 1;
+  while (result < n) {
+    result *= 2;
+  }
+  return result;
+}
+
+// A cache of at most `capacity` entries. The entries live in one array that is
+// allocated once, and are found through an open addressing index with linear
+// probing that is kept at most half full. When the cache is full the entry to
+// evict is chosen with the CLOCK algorithm: a hand sweeps over the entries,
+// clearing the referenced bit that find() sets, and evicts the first entry
+// whose bit is already clear.
+template <class Key, class Value>
+class cache {
+ public:
+  explicit cache(const size_t capacity)
+      : entries_(capacity),
+        referenced_(capacity, false),
+        index_(next_power_of_two(2 * capacity), empty) {}
+
+  // A pointer to the value cached for the key, or nullptr
+  const Value* find(const Key& key, const size_t hash) {
+    const size_t mask = index_.size() - 1;
+    for (size_t position = hash & mask;; position = (position + 1) & mask) {
+      const std::uint32_t slot = index_[position];
+      if (slot == empty) {
+        return nullptr;
+      }
+      const entry& e = *entries_[slot];
+      if (e.hash == hash and tuple_equal{}(e.key, key)) {
+        referenced_[slot] = true;
+        return &e.value;
+      }
+    }
+  }
+
+  // Inserts a key that is not in the cache, and returns whether another entry
+  // was evicted to make room for it
+  bool insert(Key key, Value value, const size_t hash) {
+    bool evicted = false;
+    size_t slot = size_;
+    if (size_ < entries_.size()) {
+      ++size_;
+    } else {
+      while (referenced_[hand_]) {
+        referenced_[hand_] = false;
+        hand_ = (hand_ + 1) % entries_.size();
+      }
+      slot = hand_;
+      hand_ = (hand_ + 1) % entries_.size();
+      erase_from_index(slot);
+      evicted = true;
+    }
+    entries_[slot].emplace(entry{std::move(key), std::move(value), hash});
+    referenced_[slot] = false;
+    const size_t mask = index_.size() - 1;
+    size_t position = hash & mask;
+    while (index_[position] != empty) {
+      position = (position + 1) & mask;
+    }
+    index_[position] = static_cast<std::uint32_t>(slot);
+    return evicted;
+  }
+
+ private:
+  struct entry {
+    Key key;
+    Value value;
+    size_t hash;
+  };
+
+  static constexpr std::uint32_t empty =
+      std::numeric_limits<std::uint32_t>::max();
+
+  // Removes the slot from the index, moving later entries of its probe run
+  // back so that no tombstones are needed
+  void erase_from_index(const size_t slot) {
+    const size_t mask = index_.size() - 1;
+    size_t hole = entries_[slot]->hash & mask;
+    while (index_[hole] != slot) {
+      hole = (hole + 1) & mask;
+    }
+    for (size_t next = (hole + 1) & mask; index_[next] != empty;
+         next = (next + 1) & mask) {
+      const size_t home = entries_[index_[next]]->hash & mask;
+      // The entry at `next` may move to the hole only if the hole is not
+      // before its home position in the probe sequence
+      if (((next - home) & mask) >= ((next - hole) & mask)) {
+        index_[hole] = index_[next];
+        hole = next;
+      }
+    }
+    index_[hole] = empty;
+  }
+
+  std::vector<std::optional<entry>> entries_;
+  std::vector<bool> referenced_;
+  std::vector<std::uint32_t> index_;
+  size_t size_ = 0;
+  size_t hand_ = 0;
+};
+}  // namespace memoize_detail
+
+/*!
+ * \brief A function wrapped with a bounded cache of its results, keyed on the
+ * tuple of its arguments. Created with memoize.
+ */
+template <size_t Capacity, class Mode, class F>
+class memoized {
+  using signature = memoize_detail::signature<F>;
+
+ public:
+  using key_type = typename signature::key_type;
+  using result_type = typename signature::result_type;
+
+  static_assert(Capacity > 0, "A memoize cache needs a capacity");
+  static_assert(Capacity < std::numeric_limits<std::uint32_t>::max(),
+                "The capacity of a memoize cache must fit in 32 bits");
+
+  explicit memoized(F f) : f_(std::move(f)) {}
+
+  template <class... Args>
+  result_type operator()(Args&&... args) {
+    key_type key{std::forward<Args>(args)...};
+    const size_t hash = tuple_hash{}(key);
+    shard& s = shards_[(hash >> 32) % Mode::shards];
+    {
+      std::lock_guard<typename Mode::mutex> lock(s.mutex);
+      if (const result_type* const value = s.cache.find(key, hash)) {
+        ++s.stats.hits;
+        return *value;
+      }
+      ++s.stats.misses;
+    }
+    // The lock is not held while computing, so that misses on the same shard
+    // from different threads are computed in parallel
+    const auto start = std::chrono::steady_clock::now();
+    result_type value = std::apply(f_, static_cast<const key_type&>(key));
+    const auto stop = std::chrono::steady_clock::now();
+    std::lock_guard<typename Mode::mutex> lock(s.mutex);
+    s.stats.compute_ns +=
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    if (s.cache.find(key, hash) == nullptr and
+        s.cache.insert(std::move(key), value, hash)) {
+      ++s.stats.evictions;
+    }
+    return value;
+  }
+
+  /// The counters summed over the shards
+  memoize_stats stats() {
+    memoize_stats result{};
+    for (shard& s : shards_) {
+      std::lock_guard<typename Mode::mutex> lock(s.mutex);
+      result.hits += s.stats.hits;
+      result.misses += s.stats.misses;
+      result.evictions += s.stats.evictions;
+      result.compute_ns += s.stats.compute_ns;
+    }
+    return result;
+  }
+
+ private:
+  static constexpr size_t shard_capacity =
+      (Capacity + Mode::shards - 1) / Mode::shards;
+
+  struct shard {
+    typename Mode::mutex mutex{};
+    memoize_detail::cache<key_type, result_type> cache{shard_capacity};
+    memoize_stats stats{};
+  };
+
+  F f_;
+  shard shards_[Mode::shards];
+};
+
+/*!
+ * \brief Wraps the pure function `f` with a cache of the results of at most
+ * `Capacity` distinct argument tuples.
+ *
+ * `f` is a function pointer or a class with one non-template call operator,
+ * and its decayed argument types, as a `std::tuple`, are the key. Keys are
+ * hashed with tuple_hash and compared with tuple_equal, so every argument type
+ * must be supported by those. The entries are stored in arrays allocated when
+ * the memoized function is created, and the least recently used entries are
+ * evicted first, approximately (CLOCK). The cache returns copies of the
+ * results.
+ *
+ * With `Mode = memoize_sharded<Shards>` the memoized function may be called
+ * from several threads at once, and `f` must then be safe to call
+ * concurrently.
+ *
+ * \code
+ * auto factor = memoize<1024>(
+ *     [](int order, int dim, int i, int j) { return ...; });
+ * const double a = factor(4, 3, 1, 2);  // computed
+ * const double b = factor(4, 3, 1, 2);  // cached
+ * assert(factor.stats().hits == 1);
+ * \endcode
+ */
+template <size_t Capacity, class Mode = memoize_single_threaded, class F>
+memoized<Capacity, Mode, F> memoize(F f) {
+  return memoized<Capacity, Mode, F>{std::move(f)};
+}
@@ -0,0 +1,214 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compares calling an expensive pure function of four integers directly, with
+ * memoize in the single threaded and sharded modes, and with an unbounded
+ * std::unordered_map<std::tuple<int, int, int, int>, double> in front of it.
+ * Prints the time per call and the hit rate when the distinct arguments fit
+ * in the cache, and when they do not but a few are much more common than the
+ * rest.
+ *
+ * Compile the code using:
+ * clang++ -std=c++17 -O3 -pthread ./memoize_benchmark.cpp
+ * g++ -std=c++17 -O3 -pthread ./memoize_benchmark.cpp
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "memoize.hpp"
+
+namespace {
+// Stands in for a geometry factor: a quadrature of a product of Legendre
+// polynomials, costing a few microseconds
+double geometry_factor(const int order, const int dim, const int i,
+                       const int j) {
+  const auto legendre = [](const int n, const double x) {
+    double previous = 1.0;
+    double current = x;
+    for (int k = 1; k < n; ++k) {
+      const double next = ((2 * k + 1) * x * current - k * previous) / (k + 1);
+      previous = current;
+      current = next;
+    }
+    return n == 0 ? 1.0 : current;
+  };
+  const int points = 64 * (order + 1);
+  double sum = 0.0;
+  for (int p = 0; p < points; ++p) {
+    const double x = -1.0 + (2.0 * p + 1.0) / points;
+    sum += legendre(i + order, x) * legendre(j + order, x) *
+           std::pow(1.0 - x * x, 0.5 * (dim - 1));
+  }
+  return 2.0 * sum / points;
+}
+
+struct call_arguments {
+  int order;
+  int dim;
+  int i;
+  int j;
+};
+
+void memoize_example() {
+  size_t calls = 0;
+  auto square = memoize<2>([&calls](const int x) {
+    ++calls;
+    return x * x;
+  });
+  assert(square(3) == 9);
+  assert(square(3) == 9);
+  assert(calls == 1);
+  assert(square(4) == 16);
+  // 3 was used since it was inserted, so the CLOCK hand passes over it and
+  // evicts 4 to make room for 5
+  assert(square(3) == 9);
+  assert(square(5) == 25);
+  assert(calls == 3);
+  assert(square(3) == 9);
+  assert(calls == 3);
+  assert(square(4) == 16);
+  assert(calls == 4);
+  const memoize_stats stats = square.stats();
+  assert(stats.hits == 3 and stats.misses == 4 and stats.evictions == 2);
+  assert(stats.hit_rate() == 3.0 / 7.0);
+
+  // Function pointers, and evicting many times through a small cache
+  auto factor = memoize<16>(&geometry_factor);
+  std::mt19937 generator(1);
+  std::uniform_int_distribution<int> index(0, 7);
+  for (size_t n = 0; n < 2000; ++n) {
+    const int i = index(generator);
+    const int j = index(generator);
+    assert(factor(2, 3, i, j) == geometry_factor(2, 3, i, j));
+  }
+  assert(factor.stats().evictions > 0);
+  assert(factor.stats().hits + factor.stats().misses == 2000);
+
+  // Several threads at once on a sharded cache
+  auto shared = memoize<64, memoize_sharded<4>>(&geometry_factor);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&shared, t]() {
+      for (int n = 0; n < 500; ++n) {
+        const int i = (n * 7 + t) % 12;
+        const int j = n % 5;
+        assert(shared(1, 2, i, j) == geometry_factor(1, 2, i, j));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  assert(shared.stats().hits + shared.stats().misses == 2000);
+}
+
+// Arguments drawn from `distinct` tuples, where 90% of the calls use the first
+// 256 of them
+std::vector<call_arguments> make_calls(const size_t count, const int distinct,
+                                  std::mt19937& generator) {
+  std::uniform_int_distribution<int> hot(0, std::min(distinct, 256) - 1);
+  std::uniform_int_distribution<int> any(0, distinct - 1);
+  std::bernoulli_distribution is_hot(0.9);
+  std::vector<call_arguments> calls(count);
+  for (auto& call : calls) {
+    const int n = is_hot(generator) ? hot(generator) : any(generator);
+    call = call_arguments{1 + n % 3, 1 + (n / 3) % 3, (n / 9) % 16, n / 144};
+  }
+  return calls;
+}
+
+template <class F>
+double ns_per_call(const std::vector<call_arguments>& calls, F&& f) {
+  volatile double sink = 0.0;
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& call : calls) {
+    sink = sink + f(call.order, call.dim, call.i, call.j);
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+         static_cast<double>(calls.size());
+}
+
+void benchmark(const int distinct, std::mt19937& generator) {
+  constexpr size_t capacity = 1024;
+  const auto calls = make_calls(100000, distinct, generator);
+
+  const double direct = ns_per_call(calls, &geometry_factor);
+
+  auto single = memoize<capacity>(&geometry_factor);
+  const double single_ns = ns_per_call(calls, single);
+
+  auto sharded = memoize<capacity, memoize_sharded<8>>(&geometry_factor);
+  const double sharded_ns = ns_per_call(calls, sharded);
+
+  std::unordered_map<std::tuple<int, int, int, int>, double, tuple_hash,
+                     tuple_equal>
+      map;
+  const double map_ns =
+      ns_per_call(calls, [&map](const int order, const int dim, const int i,
+                                const int j) {
+        const auto key = std::make_tuple(order, dim, i, j);
+        const auto found = map.find(key);
+        if (found != map.end()) {
+          return found->second;
+        }
+        const double value = geometry_factor(order, dim, i, j);
+        map.emplace(key, value);
+        return value;
+      });
+
+  std::printf("%8d | %9.1f | %9.1f %6.3f | %9.1f %6.3f | %9.1f %9zu\n",
+              distinct, direct, single_ns, single.stats().hit_rate(),
+              sharded_ns, sharded.stats().hit_rate(), map_ns, map.size());
+}
+}  // namespace
+
+int main() {
+  memoize_example();
+
+  std::mt19937 generator(42);
+  std::printf("capacity 1024, times in ns/call\n");
+  std::printf("%8s | %9s | %9s %6s | %9s %6s | %9s %9s\n", "distinct",
+              "direct", "memoize", "hits", "sharded", "hits", "map",
+              "map size");
+  benchmark(256, generator);
+  benchmark(1024, generator);
+  benchmark(16384, generator);
+}
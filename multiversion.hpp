@@ -0,0 +1,276 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Runtime dispatch between copies of a kernel compiled for different x86
+ * instruction sets.
+ *
+ * A binary that must run on old hosts is compiled for baseline x86-64, so the
+ * unrolled for_constexpr and tuple_fold kernels never use AVX2 or AVX-512
+ * even where they are available. multiversion_kernel compiles the same kernel
+ * once per instruction set through target attributes, picks the most capable
+ * one the host supports when it is constructed, and from then on calls it
+ * through a function pointer.
+ *
+ * Each version is marked `flatten` so that everything the kernel calls,
+ * including the for_constexpr and tuple_fold machinery and the lambdas passed
+ * to them, is inlined into it and compiled for its instruction set. A call
+ * that is not inlined would go to the one baseline definition shared by all
+ * the versions. GCC still applies its size limit when inlining into a function
+ * with a different target, even under `flatten`, so a lambda with a large
+ * unrolled body, such as a block of gemm_fixed larger than 4 x 4, stays a
+ * baseline call unless it is marked `ALWAYS_INLINE_LAMBDA`.
+ * `-fopt-info-inline-missed` lists the calls that were not inlined.
+ *
+ * Setting the environment variable `MULTIVERSION_ISA` to `baseline`, `avx2`
+ * or `avx512` selects that version instead, so all of them can be tested on
+ * one host. A version the host cannot run is never selected: the request is
+ * lowered to the most capable supported one.
+ *
+ * Other compilers and architectures only have the baseline version.
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define MULTIVERSION_X86
+#define MULTIVERSION_TARGET(isa) __attribute__((flatten, target(isa)))
+#define MULTIVERSION_FLATTEN __attribute__((flatten))
+#else
+#define MULTIVERSION_FLATTEN
+#endif
+
+/*!
+ * \brief The instruction sets a multiversion_kernel is compiled for, from
+ * the least to the most capable.
+ *
+ * - `baseline`: whatever the translation unit is compiled for
+ * - `avx2`: AVX2, FMA, BMI1/2 and POPCNT (Haswell and later)
+ * - `avx512`: the above plus AVX-512 F, DQ, BW and VL (Skylake-SP and later)
+ */
+enum class multiversion_isa { baseline = 0, avx2 = 1, avx512 = 2 };
+
+/*!
+ * \brief The name of `isa` as accepted by the `MULTIVERSION_ISA` environment
+ * variable
+ */
+inline const char* multiversion_isa_name(const multiversion_isa isa) {
+  switch (isa) {
+    case multiversion_isa::avx2:
+      return "avx2";
+    case multiversion_isa::avx512:
+      return "avx512";
+    default:
+      return "baseline";
+  }
+}
+
+/*!
+ * \brief The most capable instruction set that the host supports, found
+ * through CPUID (which also checks that the OS saves the vector registers).
+ */
+inline multiversion_isa multiversion_detected_isa() {
+#ifdef MULTIVERSION_X86
+  // May be called from static initializers that run before the one setting
+  // up __builtin_cpu_supports
+  __builtin_cpu_init();
+  const bool avx2 = __builtin_cpu_supports("avx2") and
+                    __builtin_cpu_supports("fma") and
+                    __builtin_cpu_supports("bmi2") and
+                    __builtin_cpu_supports("popcnt");
+  if (avx2 and __builtin_cpu_supports("avx512f") and
+      __builtin_cpu_supports("avx512dq") and
+      __builtin_cpu_supports("avx512bw") and
+      __builtin_cpu_supports("avx512vl")) {
+    return multiversion_isa::avx512;
+  }
+  if (avx2) {
+    return multiversion_isa::avx2;
+  }
+#endif
+  return multiversion_isa::baseline;
+}
+
+namespace multiversion_detail {
+inline multiversion_isa supported(const multiversion_isa isa) {
+  const multiversion_isa detected = multiversion_detected_isa();
+  return isa < detected ? isa : detected;
+}
+
+inline multiversion_isa select_isa() {
+  const char* const requested = std::getenv("MULTIVERSION_ISA");
+  if (requested != nullptr) {
+    for (const multiversion_isa isa :
+         {multiversion_isa::baseline, multiversion_isa::avx2,
+          multiversion_isa::avx512}) {
+      if (std::strcmp(requested, multiversion_isa_name(isa)) == 0) {
+        return supported(isa);
+      }
+    }
+  }
+  return multiversion_detected_isa();
+}
+
+// One copy of the call to the kernel per instruction set. The kernel is
+// stateless, so a new one is default constructed for each call and only its
+// code ends up in the copy.
+template <class F, class R, class... Args>
+MULTIVERSION_FLATTEN R call_baseline(Args... args) {
+  return F{}(std::forward<Args>(args)...);
+}
+
+#ifdef MULTIVERSION_X86
+template <class F, class R, class... Args>
+MULTIVERSION_TARGET("avx2,fma,bmi,bmi2,popcnt")
+R call_avx2(Args... args) {
+  return F{}(std::forward<Args>(args)...);
+}
+
+template <class F, class R, class... Args>
+MULTIVERSION_TARGET(
+    "avx512f,avx512dq,avx512bw,avx512vl,avx2,fma,bmi,bmi2,popcnt")
+R call_avx512(Args... args) {
+  return F{}(std::forward<Args>(args)...);
+}
+#endif
+
+template <class F, class R, class... Args>
+struct versions {
+  using pointer = R (*)(Args...);
+
+  static pointer get(const multiversion_isa isa) {
+#ifdef MULTIVERSION_X86
+    switch (isa) {
+      case multiversion_isa::avx512:
+        return &call_avx512<F, R, Args...>;
+      case multiversion_isa::avx2:
+        return &call_avx2<F, R, Args...>;
+      default:
+        break;
+    }
+#else
+    static_cast<void>(isa);
+#endif
+    return &call_baseline<F, R, Args...>;
+  }
+};
+
+template <class F, class MemberPointer>
+struct versions_of;
+
+template <class F, class R, class C, class... Args>
+struct versions_of<F, R (C::*)(Args...) const> {
+  using type = versions<F, R, Args...>;
+};
+
+#ifdef __cpp_noexcept_function_type
+template <class F, class R, class C, class... Args>
+struct versions_of<F, R (C::*)(Args...) const noexcept> {
+  using type = versions<F, R, Args...>;
+};
+#endif
+}  // namespace multiversion_detail
+
+/*!
+ * \brief The instruction set selected for every default constructed
+ * multiversion_kernel: the value of the `MULTIVERSION_ISA` environment
+ * variable if it is set and supported, otherwise the detected one. It is
+ * computed once.
+ */
+inline multiversion_isa multiversion_selected_isa() {
+  static const multiversion_isa isa = multiversion_detail::select_isa();
+  return isa;
+}
+
+/*!
+ * \brief Calls the kernel `F`, compiled for the most capable instruction set
+ * the host supports, through a function pointer chosen at construction.
+ *
+ * `F` must be an empty, default constructible type with one non-template
+ * `const` call operator, whose signature becomes that of the function
+ * pointer. A kernel object declared at namespace scope is therefore resolved
+ * once at startup, and every call after that costs one indirect call, which
+ * always goes to the same target and so is predicted. Dispatch on the
+ * outside of a loop over the data, not per element: the call cannot be
+ * inlined.
+ *
+ * \example
+ * \code
+ * struct gemm4 {
+ *   void operator()(const double* a, const double* b, double* c,
+ *                   size_t count) const {
+ *     gemm_fixed_batched<4, 4, 4>(a, b, c, count);
+ *   }
+ * };
+ * const multiversion_kernel<gemm4> gemm4_kernel{};
+ * // ...
+ * gemm4_kernel(a, b, c, count);
+ * \endcode
+ *
+ * \see multiversion_selected_isa multiversion_detected_isa
+ */
+template <class F>
+class multiversion_kernel {
+  static_assert(std::is_empty<F>::value and
+                    std::is_default_constructible<F>::value,
+                "multiversion_kernel requires a stateless kernel, since one "
+                "is default constructed in each compiled version.");
+  using versions = typename multiversion_detail::versions_of<
+      F, decltype(&F::operator())>::type;
+
+ public:
+  using pointer = typename versions::pointer;
+
+  /// Uses multiversion_selected_isa()
+  multiversion_kernel() : multiversion_kernel(multiversion_selected_isa()) {}
+
+  /// Uses `isa`, or the most capable supported one if the host cannot run it
+  explicit multiversion_kernel(const multiversion_isa isa)
+      : isa_(multiversion_detail::supported(isa)),
+        function_(versions::get(isa_)) {}
+
+  template <class... Args>
+  decltype(auto) operator()(Args&&... args) const {
+    return function_(std::forward<Args>(args)...);
+  }
+
+  multiversion_isa isa() const { return isa_; }
+
+  pointer function() const { return function_; }
+
+ private:
+  multiversion_isa isa_;
+  pointer function_;
+};
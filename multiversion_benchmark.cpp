@@ -0,0 +1,239 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Runs a for_constexpr kernel (a batch of 4 x 4 gemm_fixed) and a tuple_fold
+ * kernel (a weighted sum of columns) through multiversion_kernel, checks that
+ * every version the host supports computes the same result, and prints the
+ * time of each version and the cost of the dispatch itself.
+ *
+ * Compile for baseline x86-64, so that only the dispatch can reach AVX2 and
+ * AVX-512:
+ * clang++ -std=c++14 -O3 ./multiversion_benchmark.cpp
+ * g++ -std=c++14 -O3 ./multiversion_benchmark.cpp
+ *
+ * Run with `MULTIVERSION_ISA=baseline` (or `avx2`, `avx512`) to select a
+ * version other than the detected one.
+ */
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "fixed_kernels.hpp"
+#include "multiversion.hpp"
+#include "tuple_fold.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define NEVER_INLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NEVER_INLINE __declspec(noinline)
+#else
+#define NEVER_INLINE
+#endif
+
+namespace {
+struct gemm4 {
+  void operator()(const double* const a, const double* const b,
+                  double* const c, const size_t count) const {
+    gemm_fixed_batched<4, 4, 4>(a, b, c, count);
+  }
+};
+
+using columns = std::tuple<const double*, const double*, const double*,
+                           const double*>;
+
+struct weighted_sum {
+  // result[i] = sum_k weights[k] * column_k[i]
+  void operator()(const columns& cols, const double* const weights,
+                  double* const result, const size_t size) const {
+    for (size_t i = 0; i < size; ++i) {
+      double sum = 0.0;
+      tuple_counted_fold(
+          cols,
+          [i, weights](const double* const column, const size_t k,
+                       double& s) { s += weights[k] * column[i]; },
+          sum);
+      result[i] = sum;
+    }
+  }
+};
+
+// A kernel too small for the instruction set to matter, to time the dispatch
+struct add_one {
+  double operator()(const double x) const { return x + 1.0; }
+};
+
+const multiversion_kernel<gemm4> gemm4_kernel{};
+const multiversion_kernel<weighted_sum> weighted_sum_kernel{};
+const multiversion_kernel<add_one> add_one_kernel{};
+
+template <class F>
+double ns_per_call(const size_t calls, F&& f) {
+  size_t repetitions = 1;
+  while (true) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      f();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double elapsed_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    if (elapsed_ns > 5.0e7) {
+      return elapsed_ns / static_cast<double>(repetitions * calls);
+    }
+    repetitions *= 2;
+  }
+}
+
+// Keeps the timed calls, which have no side effects, from being removed or
+// hoisted out of the timing loop
+volatile double sink = 0.0;
+
+NEVER_INLINE double add_one_direct(const double x) { return x + 1.0; }
+
+NEVER_INLINE double sum_inlined(const size_t size) {
+  double x = sink;
+  for (size_t i = 0; i < size; ++i) {
+    x = add_one{}(x);
+  }
+  return x;
+}
+
+NEVER_INLINE double sum_direct(const size_t size) {
+  double x = sink;
+  for (size_t i = 0; i < size; ++i) {
+    x = add_one_direct(x);
+  }
+  return x;
+}
+
+NEVER_INLINE double sum_dispatched(const size_t size) {
+  double x = sink;
+  for (size_t i = 0; i < size; ++i) {
+    x = add_one_kernel(x);
+  }
+  return x;
+}
+
+std::vector<multiversion_isa> supported_isas() {
+  std::vector<multiversion_isa> result{multiversion_isa::baseline};
+  for (const multiversion_isa isa :
+       {multiversion_isa::avx2, multiversion_isa::avx512}) {
+    if (isa <= multiversion_detected_isa()) {
+      result.push_back(isa);
+    }
+  }
+  return result;
+}
+}  // namespace
+
+int main() {
+  std::printf("detected: %s, selected: %s\n",
+              multiversion_isa_name(multiversion_detected_isa()),
+              multiversion_isa_name(multiversion_selected_isa()));
+  assert(gemm4_kernel.isa() == multiversion_selected_isa());
+  // Versions the host cannot run are never selected
+  assert(multiversion_kernel<gemm4>{multiversion_isa::avx512}.isa() ==
+         multiversion_detected_isa() or
+         multiversion_detected_isa() == multiversion_isa::avx512);
+
+  std::mt19937 generator(17);
+  std::uniform_real_distribution<double> value(-1.0, 1.0);
+
+  // About 192 KiB of matrices
+  const size_t count = 512;
+  std::vector<double> a(count * 16);
+  std::vector<double> b(count * 16);
+  std::vector<double> expected_c(count * 16);
+  std::vector<double> c(count * 16);
+  for (auto& v : a) {
+    v = value(generator);
+  }
+  for (auto& v : b) {
+    v = value(generator);
+  }
+  gemm4{}(a.data(), b.data(), expected_c.data(), count);
+
+  const size_t size = 8192;
+  std::vector<double> column_data(4 * size);
+  for (auto& v : column_data) {
+    v = value(generator);
+  }
+  const columns cols{column_data.data(), column_data.data() + size,
+                     column_data.data() + 2 * size,
+                     column_data.data() + 3 * size};
+  const double weights[4] = {0.5, -1.0, 2.0, 0.25};
+  std::vector<double> expected_sum(size);
+  std::vector<double> sum(size);
+  weighted_sum{}(cols, weights, expected_sum.data(), size);
+
+  gemm4_kernel(a.data(), b.data(), c.data(), count);
+  weighted_sum_kernel(cols, weights, sum.data(), size);
+  assert(add_one_kernel(1.0) == 2.0);
+
+  std::printf("%-10s %16s %20s\n", "version", "gemm4 ns/matrix",
+              "weighted_sum ns/row");
+  for (const multiversion_isa isa : supported_isas()) {
+    const multiversion_kernel<gemm4> gemm{isa};
+    const multiversion_kernel<weighted_sum> weighted{isa};
+    assert(gemm.isa() == isa and weighted.isa() == isa);
+    // The versions may contract to fused multiply-adds differently
+    gemm(a.data(), b.data(), c.data(), count);
+    for (size_t i = 0; i < c.size(); ++i) {
+      assert(std::abs(c[i] - expected_c[i]) < 1.0e-12);
+    }
+    weighted(cols, weights, sum.data(), size);
+    for (size_t i = 0; i < size; ++i) {
+      assert(std::abs(sum[i] - expected_sum[i]) < 1.0e-12);
+    }
+    std::printf("%-10s %16.2f %20.3f\n", multiversion_isa_name(isa),
+                ns_per_call(count,
+                            [&]() {
+                              gemm(a.data(), b.data(), c.data(), count);
+                            }),
+                ns_per_call(size, [&]() {
+                  weighted(cols, weights, sum.data(), size);
+                }));
+  }
+
+  // A dependent chain of calls, so each costs its latency
+  const size_t calls = 1 << 16;
+  assert(sum_dispatched(calls) == sink + static_cast<double>(calls));
+  std::printf("add_one ns/call: inlined %.2f, direct call %.2f, "
+              "dispatched %.2f\n",
+              ns_per_call(calls, [calls]() { sink = sum_inlined(calls); }),
+              ns_per_call(calls, [calls]() { sink = sum_direct(calls); }),
+              ns_per_call(calls, [calls]() { sink = sum_dispatched(calls); }));
+}
@@ -30,12 +30,16 @@ DEALINGS IN THE SOFTWARE.
 /*
  * Compile the code using:
  * clang++ -std=c++14 -stdlib=libc++ ./part-03-iteration-cxx14.cpp
+ *
+ * Add -DTMPL_INSTRUMENT to print the calls and cycles of each call site at exit.
  */
 
 #include <iostream>
 #include <tuple>
 #include <utility>
 
+#include "tuple_fold.hpp"
+
 template <typename... Elements, size_t... Is>
 void print_helper(std::ostream& os, const std::tuple<Elements...>& t, std::index_sequence<Is...> /*meta*/) {
   static_cast<void>(std::initializer_list<char>{
@@ -51,116 +55,6 @@ std::ostream& operator<<(std::ostream& os, const std::tuple<Elements...>& t) {
   return os;
 }
 
-namespace tuple_impl_detail {
-template <bool ReverseIteration, typename... Elements, typename N_aryOp,
-          typename... Args, size_t... Is>
-constexpr void tuple_fold_impl(
-    const std::tuple<Elements...>& tupull, N_aryOp&& op,
-    std::index_sequence<Is...> /*meta*/,
-    Args&... args) noexcept(noexcept(static_cast<void>(std::initializer_list<char>{
-    (static_cast<void>(
-         op(std::get<(ReverseIteration ? sizeof...(Elements) - 1 - Is : Is)>(
-                tupull),
-            args...)),
-     '0')...}))) {
-  constexpr size_t tuple_size = sizeof...(Elements);
-  static_cast<void>(std::initializer_list<char>{
-      (static_cast<void>(
-           op(std::get<(ReverseIteration ? tuple_size - 1 - Is : Is)>(tupull),
-              args...)),
-       '0')...});
-}
-
-template <bool ReverseIteration, typename... Elements, typename N_aryOp,
-          typename... Args, size_t... Is>
-constexpr void tuple_counted_fold_impl(
-    const std::tuple<Elements...>& tupull, N_aryOp&& op,
-    std::index_sequence<Is...> /*meta*/,
-    Args&... args) noexcept(noexcept(static_cast<void>(std::initializer_list<char>{
-    (static_cast<void>(
-         op(std::get<(ReverseIteration ? sizeof...(Elements) - 1 - Is : Is)>(
-                tupull),
-            (ReverseIteration ? sizeof...(Elements) - 1 - Is : Is), args...)),
-     '0')...}))) {
-  constexpr size_t tuple_size = sizeof...(Elements);
-  static_cast<void>(std::initializer_list<char>{
-      (static_cast<void>(
-           op(std::get<(ReverseIteration ? tuple_size - 1 - Is : Is)>(tupull),
-              (ReverseIteration ? tuple_size - 1 - Is : Is), args...)),
-       '0')...});
-}
-
-template <bool ReverseIteration, typename... Elements, typename N_aryOp,
-          typename... Args, size_t... Is>
-constexpr inline void tuple_transform_impl(
-    const std::tuple<Elements...>& tupull, N_aryOp&& op,
-    std::index_sequence<Is...> /*meta*/,
-    Args&... args) noexcept(noexcept(static_cast<void>(std::initializer_list<char>{
-    (static_cast<void>(op(
-         std::get<(ReverseIteration ? sizeof...(Elements) - 1 - Is : Is)>(
-             tupull),
-         std::integral_constant<
-             size_t, (ReverseIteration ? sizeof...(Elements) - 1 - Is : Is)>{},
-         args...)),
-     '0')...}))) {
-  constexpr size_t tuple_size = sizeof...(Elements);
-  static_cast<void>(std::initializer_list<char>{(
-      static_cast<void>(op(
-          std::get<(ReverseIteration ? tuple_size - 1 - Is : Is)>(tupull),
-          std::integral_constant<size_t, (ReverseIteration ? tuple_size - 1 - Is
-                                                           : Is)>{},
-          args...)),
-      '0')...});
-}
-}  // namespace tuple_impl_detail
-
-template <bool ReverseIteration = false, typename... Elements, typename N_aryOp,
-          typename... Args>
-constexpr void tuple_fold(
-    const std::tuple<Elements...>& tuple, N_aryOp&& op,
-    Args&&... args) noexcept(noexcept(tuple_impl_detail::
-                                          tuple_fold_impl<ReverseIteration>(
-                                              tuple, std::forward<N_aryOp>(op),
-                                              std::make_index_sequence<
-                                                  sizeof...(Elements)>{},
-                                              args...))) {
-  tuple_impl_detail::tuple_fold_impl<ReverseIteration>(
-      tuple, std::forward<N_aryOp>(op),
-      std::make_index_sequence<sizeof...(Elements)>{}, args...);
-}
-
-template <bool ReverseIteration = false, typename... Elements, typename N_aryOp,
-          typename... Args>
-constexpr void tuple_counted_fold(
-    const std::tuple<Elements...>& tuple, N_aryOp&& op,
-    Args&&... args) noexcept(noexcept(tuple_impl_detail::
-                                          tuple_counted_fold_impl<
-                                              ReverseIteration>(
-                                              tuple, std::forward<N_aryOp>(op),
-                                              std::make_index_sequence<
-                                                  sizeof...(Elements)>{},
-                                              args...))) {
-  tuple_impl_detail::tuple_counted_fold_impl<ReverseIteration>(
-      tuple, std::forward<N_aryOp>(op),
-      std::make_index_sequence<sizeof...(Elements)>{}, args...);
-}
-
-template <bool ReverseIteration = false, typename... Elements, typename N_aryOp,
-          typename... Args>
-constexpr void tuple_transform(
-    const std::tuple<Elements...>& tuple, N_aryOp&& op,
-    Args&&... args) noexcept(noexcept(tuple_impl_detail::
-                                          tuple_transform_impl<
-                                              ReverseIteration>(
-                                              tuple, std::forward<N_aryOp>(op),
-                                              std::make_index_sequence<
-                                                  sizeof...(Elements)>{},
-                                              args...))) {
-  tuple_impl_detail::tuple_transform_impl<ReverseIteration>(
-      tuple, std::forward<N_aryOp>(op),
-      std::make_index_sequence<sizeof...(Elements)>{}, args...);
-}
-
 void tuple_fold_and_counted_fold_example() {
   const auto my_tupull = std::make_tuple(2, 7, -3.8, 20.9);
   double sum_value = 0.0;
@@ -0,0 +1,256 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef ALWAYS_INLINE
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define ALWAYS_INLINE __attribute__((always_inline)) inline
+#elif defined(_MSC_VER) && !defined(__INTEL_COMPILER)
+#define ALWAYS_INLINE __forceinline inline
+#else
+#define ALWAYS_INLINE inline  // :(
+#endif
+#endif
+
+/*!
+ * \brief A pipeline stage that passes on the elements for which `predicate`
+ * returns true and drops the others. Created with filter_stage.
+ */
+template <class Predicate>
+struct pipeline_filter {
+  Predicate predicate;
+};
+
+template <class Predicate>
+constexpr pipeline_filter<Predicate> filter_stage(Predicate predicate) {
+  return pipeline_filter<Predicate>{std::move(predicate)};
+}
+
+namespace pipeline_detail {
+template <class Stage>
+struct is_filter : std::false_type {};
+
+template <class Predicate>
+struct is_filter<pipeline_filter<Predicate>> : std::true_type {};
+
+template <class Stage, class T, bool = is_filter<Stage>::value>
+struct stage_result {
+  using type = std::decay_t<std::invoke_result_t<Stage&, T>>;
+};
+
+template <class Stage, class T>
+struct stage_result<Stage, T, true> {
+  using type = std::decay_t<T>;
+};
+
+template <class T, class... Stages>
+struct pipeline_result {
+  using type = std::decay_t<T>;
+};
+
+template <class T, class Stage, class... Stages>
+struct pipeline_result<T, Stage, Stages...>
+    : pipeline_result<typename stage_result<Stage, T>::type, Stages...> {};
+
+// Passes `value` through stages I, I + 1, ... and the sink. Every stage is a
+// direct call on the result of the previous one, so after inlining an element
+// stays in registers from the first stage to the sink, and a filter that
+// drops it skips the remaining stages with a branch.
+template <size_t I, class... Stages, class T, class Sink>
+ALWAYS_INLINE void push(std::tuple<Stages...>& stages, T&& value,
+                        Sink& sink) {
+  if constexpr (I == sizeof...(Stages)) {
+    sink(std::forward<T>(value));
+  } else {
+    auto& stage = std::get<I>(stages);
+    if constexpr (is_filter<std::decay_t<decltype(stage)>>::value) {
+      if (stage.predicate(static_cast<const std::decay_t<T>&>(value))) {
+        push<I + 1>(stages, std::forward<T>(value), sink);
+      }
+    } else {
+      push<I + 1>(stages, stage(std::forward<T>(value)), sink);
+    }
+  }
+}
+
+// The index of the first of the filters that end the stages, or the number of
+// stages if the last stage is not a filter
+template <class... Stages>
+constexpr size_t trailing_filters_begin() {
+  constexpr bool filters[] = {false, is_filter<Stages>::value...};
+  size_t begin = sizeof...(Stages);
+  while (begin > 0 and filters[begin]) {
+    --begin;
+  }
+  return begin;
+}
+
+// Evaluates all the filters from I on without short-circuiting, so that
+// there is no branch on their results
+template <size_t I, class... Stages, class T>
+ALWAYS_INLINE bool all_pass(std::tuple<Stages...>& stages, const T& value) {
+  if constexpr (I == sizeof...(Stages)) {
+    return true;
+  } else {
+    return static_cast<bool>(std::get<I>(stages).predicate(value) &
+                             all_pass<I + 1>(stages, value));
+  }
+}
+
+// Like push, but the filters that end the stages are not branched on. The
+// result is always passed to `write` together with whether to keep it, so
+// that an unpredictable filter does not cost a branch misprediction and the
+// work on the next elements can overlap with the current one. Filters before
+// the last transforming stage still branch, so that no stage sees an element
+// that an earlier filter dropped.
+template <size_t I, class... Stages, class T, class Write>
+ALWAYS_INLINE void push_predicated(std::tuple<Stages...>& stages, T&& value,
+                                   Write& write) {
+  if constexpr (I == trailing_filters_begin<Stages...>()) {
+    const bool keep = all_pass<I>(stages, value);
+    write(std::forward<T>(value), keep);
+  } else {
+    auto& stage = std::get<I>(stages);
+    if constexpr (is_filter<std::decay_t<decltype(stage)>>::value) {
+      if (stage.predicate(static_cast<const std::decay_t<T>&>(value))) {
+        push_predicated<I + 1>(stages, std::forward<T>(value), write);
+      }
+    } else {
+      push_predicated<I + 1>(stages, stage(std::forward<T>(value)), write);
+    }
+  }
+}
+}  // namespace pipeline_detail
+
+/*!
+ * \brief A chain of per-element stages fused into one pass. Created with
+ * make_pipeline.
+ *
+ * `p(value, sink)` passes one element through all the stages and calls
+ * `sink(result)` unless a filter dropped it. `p.run(input, count, sink)` does
+ * so for `count` elements, collecting the results in a batch of at most
+ * `BatchBytes` bytes (16 KiB by default, half of a typical L1 data cache) and
+ * calling `sink(results, size)` with each batch while it is still in cache.
+ * Nothing is stored between stages. When the results are trivially copyable,
+ * run writes every result to the batch and only advances past those that the
+ * filters at the end of the chain keep, instead of branching on the filters.
+ */
+template <class... Stages>
+class pipeline {
+ public:
+  template <class T>
+  using result_type =
+      typename pipeline_detail::pipeline_result<T, Stages...>::type;
+
+  constexpr explicit pipeline(Stages... stages)
+      : stages_(std::move(stages)...) {}
+
+  template <class T, class Sink>
+  ALWAYS_INLINE void operator()(T&& value, Sink&& sink) {
+    pipeline_detail::push<0>(stages_, std::forward<T>(value), sink);
+  }
+
+  template <size_t BatchBytes = 16384, class T, class BatchSink>
+  void run(const T* const input, const size_t count, BatchSink&& sink) {
+    using result = result_type<const T&>;
+    constexpr size_t batch_size = std::max(BatchBytes / sizeof(result),
+                                           static_cast<size_t>(1));
+    // The input is consumed in chunks of batch_size, so that a batch never
+    // overflows and the sink sees each result once
+    if constexpr (std::is_trivially_copyable<result>::value and
+                  std::is_default_constructible<result>::value) {
+      std::vector<result> batch(std::min(batch_size, count));
+      for (size_t begin = 0; begin < count; begin += batch_size) {
+        const size_t end = std::min(begin + batch_size, count);
+        size_t size = 0;
+        const auto write = [&batch, &size](const result& r, const bool keep) {
+          batch[size] = r;
+          size += keep ? 1 : 0;
+        };
+        for (size_t i = begin; i < end; ++i) {
+          pipeline_detail::push_predicated<0>(stages_, input[i], write);
+        }
+        if (size != 0) {
+          sink(static_cast<const result*>(batch.data()), size);
+        }
+      }
+    } else {
+      std::vector<result> batch{};
+      batch.reserve(std::min(batch_size, count));
+      const auto append = [&batch](auto&& r) {
+        batch.push_back(std::forward<decltype(r)>(r));
+      };
+      for (size_t begin = 0; begin < count; begin += batch_size) {
+        const size_t end = std::min(begin + batch_size, count);
+        for (size_t i = begin; i < end; ++i) {
+          pipeline_detail::push<0>(stages_, input[i], append);
+        }
+        if (not batch.empty()) {
+          sink(static_cast<const result*>(batch.data()), batch.size());
+          batch.clear();
+        }
+      }
+    }
+  }
+
+ private:
+  std::tuple<Stages...> stages_;
+};
+
+/*!
+ * \brief Fuses the `stages` into a pipeline that runs them one element at a
+ * time.
+ *
+ * Each stage is a function object applied to the result of the previous
+ * stage, or a filter_stage. Stages that accept several element types can be
+ * written as overload sets with make_overloader.
+ *
+ * \code
+ * auto p = make_pipeline([](std::uint32_t raw) { return decode(raw); },
+ *                        [](const sample& s) { return normalize(s); },
+ *                        [](const sample& s) { return score(s); },
+ *                        filter_stage([](double x) { return x > 0.5; }));
+ * double sum = 0.0;
+ * p.run(raw.data(), raw.size(), [&sum](const double* scores, size_t size) {
+ *   sum += std::accumulate(scores, scores + size, 0.0);
+ * });
+ * \endcode
+ */
+template <class... Stages>
+constexpr pipeline<Stages...> make_pipeline(Stages... stages) {
+  return pipeline<Stages...>{std::move(stages)...};
+}
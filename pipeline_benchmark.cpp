@@ -0,0 +1,233 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compares running a decode -> normalize -> score -> filter chain fused with
+ * make_pipeline against running each stage over the whole input before the
+ * next one, storing the intermediate results in arrays. Prints the time per
+ * input element for inputs that fit in L1, in L2, and in neither.
+ *
+ * Compile the code using:
+ * clang++ -std=c++17 -O3 ./pipeline_benchmark.cpp
+ * g++ -std=c++17 -O3 ./pipeline_benchmark.cpp
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "overloader.hpp"
+#include "pipeline.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define NEVER_INLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NEVER_INLINE __declspec(noinline)
+#else
+#define NEVER_INLINE
+#endif
+
+namespace {
+struct sample {
+  float x;
+  float y;
+};
+
+// Two 16-bit fixed point coordinates packed in 32 bits
+struct decode {
+  sample operator()(const std::uint32_t raw) const {
+    return {static_cast<float>(raw & 0xFFFF) * (1.0f / 65535.0f),
+            static_cast<float>(raw >> 16) * (1.0f / 65535.0f)};
+  }
+};
+
+struct normalize {
+  sample operator()(const sample& s) const {
+    return {2.0f * s.x - 1.0f, 2.0f * s.y - 1.0f};
+  }
+};
+
+struct score {
+  float operator()(const sample& s) const {
+    const float r2 = s.x * s.x + s.y * s.y;
+    return 1.0f - r2 * (0.5f - r2 * (1.0f / 24.0f));
+  }
+};
+
+struct keep {
+  bool operator()(const float s) const { return s > 0.75f; }
+};
+
+void pipeline_example() {
+  // Stages can change the element type, and filters drop elements
+  auto p = make_pipeline([](const int x) { return x * 3; },
+                         filter_stage([](const int x) { return x % 2 == 0; }),
+                         [](const int x) { return std::to_string(x); });
+  std::vector<std::string> out{};
+  for (int i = 0; i < 5; ++i) {
+    p(i, [&out](std::string s) { out.push_back(std::move(s)); });
+  }
+  assert((out == std::vector<std::string>{"0", "6", "12"}));
+  const int numbers[] = {0, 1, 2, 3, 4};
+  std::string joined{};
+  p.run(numbers, 5, [&joined](const std::string* s, const size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      joined += s[i] + " ";
+    }
+  });
+  assert(joined == "0 6 12 ");
+
+  // An overload set as a stage, and results delivered in batches
+  auto describe = make_pipeline(make_overloader(
+      [](const int x) { return static_cast<double>(x); },
+      [](const double x) { return x * 0.5; }));
+  double sum = 0.0;
+  describe(4, [&sum](const double x) { sum += x; });
+  describe(4.0, [&sum](const double x) { sum += x; });
+  assert(sum == 6.0);
+
+  std::vector<int> input(1000);
+  for (int i = 0; i < 1000; ++i) {
+    input[static_cast<size_t>(i)] = i;
+  }
+  auto evens =
+      make_pipeline(filter_stage([](const int x) { return x % 2 == 0; }));
+  size_t batches = 0;
+  std::vector<int> kept{};
+  evens.run<64>(input.data(), input.size(),
+                [&batches, &kept](const int* results, const size_t size) {
+                  assert(size <= 16);
+                  ++batches;
+                  kept.insert(kept.end(), results, results + size);
+                });
+  assert(kept.size() == 500 and kept[1] == 2 and kept[499] == 998);
+  assert(batches == 63);
+}
+
+NEVER_INLINE double fused(const std::vector<std::uint32_t>& raw) {
+  auto p = make_pipeline(decode{}, normalize{}, score{}, filter_stage(keep{}));
+  double sum = 0.0;
+  p.run(raw.data(), raw.size(), [&sum](const float* scores, const size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      sum += scores[i];
+    }
+  });
+  return sum;
+}
+
+NEVER_INLINE double fused_unbatched(const std::vector<std::uint32_t>& raw) {
+  auto p = make_pipeline(decode{}, normalize{}, score{}, filter_stage(keep{}));
+  double sum = 0.0;
+  for (const std::uint32_t r : raw) {
+    p(r, [&sum](const float s) { sum += s; });
+  }
+  return sum;
+}
+
+struct buffers {
+  std::vector<sample> decoded;
+  std::vector<sample> normalized;
+  std::vector<float> scores;
+  std::vector<float> kept;
+};
+
+NEVER_INLINE double stage_at_a_time(const std::vector<std::uint32_t>& raw,
+                                    buffers& b) {
+  b.decoded.resize(raw.size());
+  b.normalized.resize(raw.size());
+  b.scores.resize(raw.size());
+  b.kept.resize(raw.size());
+  std::transform(raw.begin(), raw.end(), b.decoded.begin(), decode{});
+  std::transform(b.decoded.begin(), b.decoded.end(), b.normalized.begin(),
+                 normalize{});
+  std::transform(b.normalized.begin(), b.normalized.end(), b.scores.begin(),
+                 score{});
+  const auto end =
+      std::copy_if(b.scores.begin(), b.scores.end(), b.kept.begin(), keep{});
+  double sum = 0.0;
+  for (auto it = b.kept.begin(); it != end; ++it) {
+    sum += *it;
+  }
+  return sum;
+}
+
+template <class F>
+double ns_per_element(const size_t elements, F&& f) {
+  size_t repetitions = 1;
+  while (true) {
+    volatile double sink = 0.0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      sink = sink + f();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double elapsed_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    if (elapsed_ns > 1.0e8) {
+      return elapsed_ns / static_cast<double>(repetitions * elements);
+    }
+    repetitions *= 2;
+  }
+}
+
+void benchmark(const size_t size, std::mt19937& generator) {
+  std::vector<std::uint32_t> raw(size);
+  for (auto& r : raw) {
+    r = static_cast<std::uint32_t>(generator());
+  }
+  buffers b{};
+  const double expected = stage_at_a_time(raw, b);
+  assert(fused(raw) == expected);
+  assert(fused_unbatched(raw) == expected);
+  std::printf("%10zu | %14.3f %14.3f %14.3f\n", size,
+              ns_per_element(size, [&]() { return stage_at_a_time(raw, b); }),
+              ns_per_element(size, [&]() { return fused(raw); }),
+              ns_per_element(size, [&]() { return fused_unbatched(raw); }));
+}
+}  // namespace
+
+int main() {
+  pipeline_example();
+
+  std::mt19937 generator(42);
+  std::printf("%10s | %14s %14s %14s\n", "elements", "stage at once",
+              "fused batched", "fused");
+  std::printf("%10s | %14s %14s %14s\n", "", "ns/element", "ns/element",
+              "ns/element");
+  benchmark(1 << 10, generator);
+  benchmark(1 << 14, generator);
+  benchmark(1 << 22, generator);
+}
@@ -0,0 +1,290 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "for_constexpr.hpp"
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Scheme for poly_eval: Horner's rule, `c0 + x * (c1 + x * (c2 +
+ * ...))`, a chain of one multiply-add per coefficient.
+ *
+ * Horner's rule uses the fewest operations, but each one waits for the one
+ * before, so a single evaluation takes the latency of the whole chain. It is
+ * the better scheme when many independent evaluations overlap anyway, as in
+ * the batched poly_eval.
+ */
+struct poly_horner {};
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Scheme for poly_eval: Estrin's scheme, which evaluates the lower and
+ * upper halves of the coefficients independently and combines them as
+ * `low + x^m * high`, where `m` is a power of two.
+ *
+ * The powers `x, x^2, x^4, ...` are computed once by squaring, and the split
+ * of the coefficients is unrolled at compile time, so that the critical path
+ * has about `2 log2(degree)` operations instead of `degree` multiply-adds, at
+ * the cost of the extra squarings and multiplications.
+ */
+struct poly_estrin {};
+
+namespace poly_eval_detail {
+using std::get;
+
+// A coefficient known at compile time is an empty type with a static `value`
+// member, such as a std::integral_constant
+template <class C, class = void>
+struct is_constant : std::false_type {};
+
+template <class C>
+struct is_constant<C, std::void_t<decltype(C::value)>> : std::true_type {};
+
+template <class C>
+constexpr bool is_zero() {
+  if constexpr (is_constant<C>::value) {
+    return C::value == 0;
+  } else {
+    return false;
+  }
+}
+
+template <class C>
+constexpr bool is_one() {
+  if constexpr (is_constant<C>::value) {
+    return C::value == 1;
+  } else {
+    return false;
+  }
+}
+
+using zero = std::integral_constant<int, 0>;
+
+template <class T, class C>
+ALWAYS_INLINE constexpr T value(const C& c) {
+  if constexpr (is_constant<C>::value) {
+    return static_cast<T>(C::value);
+  } else {
+    return static_cast<T>(c);
+  }
+}
+
+// The sum and product of two terms, either of which may be a compile time
+// constant. Adding zero and multiplying by one or zero are resolved by the
+// types, so they emit no instructions, and the result stays a constant when
+// it is zero.
+template <class T, class A, class B>
+ALWAYS_INLINE constexpr auto add(const A& a, const B& b) {
+  if constexpr (is_zero<A>()) {
+    return b;
+  } else if constexpr (is_zero<B>()) {
+    return a;
+  } else {
+    return static_cast<T>(value<T>(a) + value<T>(b));
+  }
+}
+
+template <class T, class A, class B>
+ALWAYS_INLINE constexpr auto multiply(const A& a, const B& b) {
+  if constexpr (is_zero<A>() or is_zero<B>()) {
+    return zero{};
+  } else if constexpr (is_one<A>()) {
+    return b;
+  } else if constexpr (is_one<B>()) {
+    return a;
+  } else {
+    return static_cast<T>(value<T>(a) * value<T>(b));
+  }
+}
+
+template <class Coefficients>
+constexpr size_t size_v = std::tuple_size<Coefficients>::value;
+
+template <size_t I, class T, class Coefficients>
+ALWAYS_INLINE constexpr auto horner(const Coefficients& coefficients,
+                                    const T& x) {
+  if constexpr (I == size_v<Coefficients>) {
+    return zero{};
+  } else {
+    return add<T>(get<I>(coefficients),
+                  multiply<T>(horner<I + 1>(coefficients, x), x));
+  }
+}
+
+constexpr size_t floor_log2(const size_t n) {
+  size_t result = 0;
+  while ((n >> result) > 1) {
+    ++result;
+  }
+  return result;
+}
+
+// The number of powers x^(2^k) used by Estrin's scheme for Size coefficients
+constexpr size_t power_count(const size_t size) {
+  return size < 2 ? 0 : floor_log2(size - 1) + 1;
+}
+
+// Evaluates the coefficients [Begin, End) as a polynomial in x, splitting off
+// the largest power of two of them as the lower half, whose upper neighbour
+// is then multiplied by `powers[level] = x^(2^level)`
+template <size_t Begin, size_t End, class T, class Coefficients,
+          class Powers>
+ALWAYS_INLINE constexpr auto estrin(const Coefficients& coefficients,
+                                    const Powers& powers) {
+  if constexpr (Begin == End) {
+    return zero{};
+  } else if constexpr (Begin + 1 == End) {
+    return get<Begin>(coefficients);
+  } else {
+    constexpr size_t level = floor_log2(End - Begin - 1);
+    constexpr size_t middle = Begin + (size_t{1} << level);
+    return add<T>(estrin<Begin, middle, T>(coefficients, powers),
+                  multiply<T>(estrin<middle, End, T>(coefficients, powers),
+                              powers[level]));
+  }
+}
+
+template <const auto& Coefficients, size_t I>
+struct array_coefficient {
+  static constexpr auto value = Coefficients[I];
+};
+
+template <const auto& Coefficients, size_t... Is>
+constexpr std::tuple<array_coefficient<Coefficients, Is>...>
+constant_coefficients(std::index_sequence<Is...> /*meta*/) {
+  return {};
+}
+}  // namespace poly_eval_detail
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Evaluates `c[0] + c[1] * x + ... + c[n-1] * x^(n-1)` with Scheme
+ * (poly_horner or poly_estrin), fully unrolled at compile time.
+ *
+ * `coefficients` is a std::tuple or a std::array, in order of increasing
+ * power. Elements of a tuple may be compile time constants like
+ * `std::integral_constant<int, 0>`: the terms of zero coefficients are
+ * skipped, and coefficients of one are not multiplied. To have this for
+ * floating point coefficients as well, pass a `constexpr` array as the
+ * template parameter instead.
+ *
+ * \code
+ * using zero = std::integral_constant<int, 0>;
+ * using one = std::integral_constant<int, 1>;
+ * // x - x^3 / 6 + x^5 / 120
+ * const auto sin5 = std::make_tuple(zero{}, one{}, zero{}, -1.0 / 6.0,
+ *                                   zero{}, 1.0 / 120.0);
+ * const double y = poly_eval<poly_estrin>(sin5, x);
+ * \endcode
+ */
+template <class Scheme, class Coefficients, class T>
+constexpr T poly_eval(const Coefficients& coefficients, const T& x) {
+  using poly_eval_detail::size_v;
+  if constexpr (std::is_same<Scheme, poly_horner>::value) {
+    return poly_eval_detail::value<T>(
+        poly_eval_detail::horner<0>(coefficients, x));
+  } else {
+    static_assert(std::is_same<Scheme, poly_estrin>::value,
+                  "The Scheme must be poly_horner or poly_estrin");
+    constexpr size_t power_count =
+        poly_eval_detail::power_count(size_v<Coefficients>);
+    std::array<T, power_count> powers{};
+    if constexpr (power_count > 0) {
+      powers[0] = x;
+      for_constexpr<for_bounds<1, power_count>>(
+          [&powers](auto k) ALWAYS_INLINE_LAMBDA {
+            powers[k] = powers[k - 1] * powers[k - 1];
+          });
+    }
+    return poly_eval_detail::value<T>(
+        poly_eval_detail::estrin<0, size_v<Coefficients>, T>(coefficients,
+                                                              powers));
+  }
+}
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Evaluates the polynomial with the coefficients in the `constexpr`
+ * array (or std::array) `Coefficients`, which must have static storage
+ * duration, skipping zero coefficients and multiplications by one.
+ *
+ * \code
+ * static constexpr std::array<double, 4> exp3{
+ *     {1.0, 1.0, 1.0 / 2.0, 1.0 / 6.0}};
+ * const double y = poly_eval<poly_horner, exp3>(x);
+ * \endcode
+ */
+template <class Scheme, const auto& Coefficients, class T>
+constexpr T poly_eval(const T& x) {
+  return poly_eval<Scheme>(
+      poly_eval_detail::constant_coefficients<Coefficients>(
+          std::make_index_sequence<std::size(Coefficients)>{}),
+      x);
+}
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Computes `result[i] = poly_eval<Scheme>(coefficients, x[i])` for
+ * `count` values.
+ *
+ * The evaluations are independent, so the loop is vectorized with the
+ * coefficients broadcast to SIMD registers, and the vector lanes hide the
+ * latency of Horner's chain. Estrin's scheme then only adds operations, but
+ * can still help for polynomials of high degree where the chain is longer
+ * than the loop pipelining can hide.
+ */
+template <class Scheme, class Coefficients, class T>
+void poly_eval(const Coefficients& coefficients, const T* const x,
+               T* const result, const size_t count) {
+  // A local copy cannot alias `result`, so the coefficients are loaded once
+  const Coefficients local_coefficients = coefficients;
+  for (size_t i = 0; i < count; ++i) {
+    result[i] = poly_eval<Scheme>(local_coefficients, x[i]);
+  }
+}
+
+/*!
+ * \ingroup UtilitiesGroup
+ * \brief Computes `result[i] = poly_eval<Scheme, Coefficients>(x[i])` for
+ * `count` values.
+ */
+template <class Scheme, const auto& Coefficients, class T>
+void poly_eval(const T* const x, T* const result, const size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    result[i] = poly_eval<Scheme, Coefficients>(x[i]);
+  }
+}
@@ -0,0 +1,287 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Evaluates two fixed polynomials, the Taylor series of exp to degree 13 and
+ * of sin to degree 15, with a Horner chain written as a tuple_counted_fold
+ * and with poly_eval's Horner and Estrin schemes, both for coefficients only
+ * known at run time and for constexpr coefficients, where the zero and one
+ * coefficients are folded away. Prints the latency of one evaluation that
+ * depends on the previous one and the throughput of the batched overload.
+ *
+ * Compile the code using:
+ * clang++ -std=c++17 -O3 -march=native ./poly_eval_benchmark.cpp
+ * g++ -std=c++17 -O3 -march=native ./poly_eval_benchmark.cpp
+ */
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "poly_eval.hpp"
+#include "tuple_fold.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define NEVER_INLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NEVER_INLINE __declspec(noinline)
+#else
+#define NEVER_INLINE
+#endif
+
+namespace {
+using zero = std::integral_constant<int, 0>;
+using one = std::integral_constant<int, 1>;
+
+// 1 + 2 x + 3 x^2 at x = 2
+static_assert(poly_eval<poly_horner>(std::array<int, 3>{{1, 2, 3}}, 2) == 17,
+              "");
+static_assert(poly_eval<poly_estrin>(std::array<int, 3>{{1, 2, 3}}, 2) == 17,
+              "");
+// x^4 - 2 x at x = 3, where only two terms remain
+static_assert(poly_eval<poly_estrin>(
+                  std::make_tuple(zero{}, -2, zero{}, zero{}, one{}), 3) ==
+                  75,
+              "");
+static_assert(poly_eval<poly_horner>(std::tuple<>{}, 3) == 0, "");
+static_assert(poly_eval<poly_estrin>(std::make_tuple(zero{}), 3) == 0, "");
+
+constexpr size_t exp_size = 14;
+constexpr size_t sin_size = 16;
+
+constexpr std::array<double, exp_size> exp_taylor() {
+  std::array<double, exp_size> result{};
+  double term = 1.0;
+  for (size_t k = 0; k < exp_size; ++k) {
+    result[k] = term;
+    term /= static_cast<double>(k + 1);
+  }
+  return result;
+}
+
+constexpr std::array<double, sin_size> sin_taylor() {
+  std::array<double, sin_size> result{};
+  double term = 1.0;
+  for (size_t k = 1; k < sin_size; k += 2) {
+    result[k] = term;
+    term /= -static_cast<double>((k + 1) * (k + 2));
+  }
+  return result;
+}
+
+constexpr std::array<double, exp_size> exp_coefficients = exp_taylor();
+constexpr std::array<double, sin_size> sin_coefficients = sin_taylor();
+
+template <size_t N, size_t... Is>
+auto as_tuple(const std::array<double, N>& a,
+              std::index_sequence<Is...> /*meta*/) {
+  return std::make_tuple(a[Is]...);
+}
+
+// The coefficients as a tuple of doubles read through a volatile, so that
+// the compiler cannot see their values
+template <size_t N>
+auto runtime_coefficients(const std::array<double, N>& coefficients) {
+  std::array<double, N> result{};
+  for (size_t k = 0; k < N; ++k) {
+    const volatile double c = coefficients[k];
+    result[k] = c;
+  }
+  return as_tuple(result, std::make_index_sequence<N>{});
+}
+
+using exp_tuple = decltype(runtime_coefficients(exp_coefficients));
+using sin_tuple = decltype(runtime_coefficients(sin_coefficients));
+
+// Horner's rule written directly as a fold over the coefficients
+template <class Coefficients>
+double fold_horner(const Coefficients& coefficients, const double x) {
+  double result = 0.0;
+  tuple_counted_fold<true>(
+      coefficients,
+      [x](const double c, const size_t /*k*/, double& r) { r = r * x + c; },
+      result);
+  return result;
+}
+
+// The evaluations of each polynomial: [0] is fold_horner and [1], [2] are
+// poly_eval with run time coefficients, [3], [4] with constexpr ones
+template <const auto& Constant, class Tuple>
+struct evaluations {
+  explicit evaluations(const Tuple& c) : coefficients(c) {}
+
+  template <size_t I>
+  double operator()(std::integral_constant<size_t, I> /*meta*/,
+                    const double x) const {
+    if constexpr (I == 0) {
+      return fold_horner(coefficients, x);
+    } else if constexpr (I == 1) {
+      return poly_eval<poly_horner>(coefficients, x);
+    } else if constexpr (I == 2) {
+      return poly_eval<poly_estrin>(coefficients, x);
+    } else if constexpr (I == 3) {
+      return poly_eval<poly_horner, Constant>(x);
+    } else {
+      return poly_eval<poly_estrin, Constant>(x);
+    }
+  }
+
+  template <size_t I>
+  void operator()(std::integral_constant<size_t, I> /*meta*/,
+                  const double* const x, double* const result,
+                  const size_t count) const {
+    if constexpr (I == 0) {
+      for (size_t i = 0; i < count; ++i) {
+        result[i] = fold_horner(coefficients, x[i]);
+      }
+    } else if constexpr (I == 1) {
+      poly_eval<poly_horner>(coefficients, x, result, count);
+    } else if constexpr (I == 2) {
+      poly_eval<poly_estrin>(coefficients, x, result, count);
+    } else if constexpr (I == 3) {
+      poly_eval<poly_horner, Constant>(x, result, count);
+    } else {
+      poly_eval<poly_estrin, Constant>(x, result, count);
+    }
+  }
+
+  Tuple coefficients;
+};
+
+constexpr size_t evaluation_count = 5;
+
+template <class F>
+double ns_per_call(const size_t calls, F&& f) {
+  size_t repetitions = 1;
+  while (true) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      f();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double elapsed_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    if (elapsed_ns > 5.0e7) {
+      return elapsed_ns / static_cast<double>(repetitions * calls);
+    }
+    repetitions *= 2;
+  }
+}
+
+volatile double sink = 0.0;
+
+// Each x is computed from the previous result, so the evaluations cannot
+// overlap. The map has an attracting fixed point for both polynomials.
+template <size_t I, class Evaluations>
+NEVER_INLINE void latency(const Evaluations& evaluate, const size_t count) {
+  double x = sink;
+  for (size_t i = 0; i < count; ++i) {
+    x = 0.25 * evaluate(std::integral_constant<size_t, I>{}, x) + 0.25;
+  }
+  sink = x;
+}
+
+template <size_t I, class Evaluations>
+NEVER_INLINE void throughput(const Evaluations& evaluate,
+                             const std::vector<double>& x,
+                             std::vector<double>& result) {
+  evaluate(std::integral_constant<size_t, I>{}, x.data(), result.data(),
+           x.size());
+}
+
+template <class Evaluations>
+void benchmark(const char* const name, const Evaluations& evaluate,
+               double (*const exact)(double)) {
+  std::mt19937 generator(11);
+  std::uniform_real_distribution<double> value(-0.5, 0.5);
+  // 8 KiB of arguments, so that the loads and stores stay in L1
+  std::vector<double> x(1024);
+  for (auto& v : x) {
+    v = value(generator);
+  }
+  std::vector<double> result(x.size());
+
+  std::array<double, evaluation_count> latency_ns{};
+  std::array<double, evaluation_count> throughput_ns{};
+  for_constexpr<for_bounds<0, evaluation_count>>([&](auto i) {
+    for (const double v : x) {
+      assert(std::abs(evaluate(i, v) - exact(v)) < 1.0e-14);
+    }
+    std::fill(result.begin(), result.end(), 0.0);
+    throughput<i>(evaluate, x, result);
+    for (size_t k = 0; k < x.size(); ++k) {
+      assert(std::abs(result[k] - exact(x[k])) < 1.0e-14);
+    }
+
+    const size_t steps = 1024;
+    latency_ns[i] =
+        ns_per_call(steps, [&evaluate, i]() { latency<i>(evaluate, steps); });
+    throughput_ns[i] = ns_per_call(
+        x.size(), [&evaluate, &x, &result, i]() {
+          throughput<i>(evaluate, x, result);
+        });
+  });
+
+  std::printf("%-4s latency    ", name);
+  for (const double t : latency_ns) {
+    std::printf(" %9.2f", t);
+  }
+  std::printf("\n%-4s throughput ", name);
+  for (const double t : throughput_ns) {
+    std::printf(" %9.2f", t);
+  }
+  std::printf("\n");
+}
+
+double exp_exact(const double x) { return std::exp(x); }
+double sin_exact(const double x) { return std::sin(x); }
+}  // namespace
+
+int main() {
+  const evaluations<exp_coefficients, exp_tuple> exp_evaluations{
+      runtime_coefficients(exp_coefficients)};
+  const evaluations<sin_coefficients, sin_tuple> sin_evaluations{
+      runtime_coefficients(sin_coefficients)};
+
+  std::printf("ns per evaluation\n");
+  std::printf("%16s %9s %9s %9s %9s %9s\n", "", "fold", "horner", "estrin",
+              "horner", "estrin");
+  std::printf("%16s %9s %19s %19s\n", "", "", "run time coefficients",
+              "constexpr coefficients");
+  benchmark("exp", exp_evaluations, exp_exact);
+  benchmark("sin", sin_evaluations, sin_exact);
+}
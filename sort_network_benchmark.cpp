@@ -0,0 +1,268 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Sorts many small arrays of random keys with std::sort, insertion sort and
+ * sort_network, for N = 4 to 32, and prints the time per array. The
+ * key-value variant is compared with std::sort of (key, value) pairs. Every
+ * network is first checked against std::sort, and for N up to 20 on all
+ * 2^N inputs of zeros and ones, which by the 0-1 principle shows that it
+ * sorts every input.
+ *
+ * Compile the code using:
+ * clang++ -std=c++17 -O3 -march=native ./sort_network_benchmark.cpp
+ * g++ -std=c++17 -O3 -march=native ./sort_network_benchmark.cpp
+ */
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "sort_network.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define NEVER_INLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NEVER_INLINE __declspec(noinline)
+#else
+#define NEVER_INLINE
+#endif
+
+static_assert(sort_network_schedule<0>.size() == 0);
+static_assert(sort_network_schedule<1>.size() == 0);
+static_assert(sort_network_schedule<4>.size() == 5);
+static_assert(sort_network_schedule<8>.size() == 19);
+static_assert(sort_network_schedule<16>.size() == 63);
+static_assert(sort_network_schedule<32>.size() == 191);
+
+namespace {
+template <size_t N>
+constexpr std::array<int, N> sorted_constant(std::array<int, N> values) {
+  sort_network(values);
+  return values;
+}
+
+constexpr std::array<int, 5> sorted_five =
+    sorted_constant<5>({{3, 1, 4, 1, 5}});
+static_assert(sorted_five[0] == 1 and sorted_five[1] == 1 and
+              sorted_five[2] == 3 and sorted_five[3] == 4 and
+              sorted_five[4] == 5);
+
+template <size_t N, class T>
+void insertion_sort(std::array<T, N>& values) {
+  for (size_t i = 1; i < N; ++i) {
+    const T value = values[i];
+    size_t j = i;
+    for (; j > 0 and value < values[j - 1]; --j) {
+      values[j] = values[j - 1];
+    }
+    values[j] = value;
+  }
+}
+
+template <size_t N>
+void check_network(std::mt19937& generator) {
+  if constexpr (N <= 20) {
+    for (std::uint32_t bits = 0; bits < (std::uint32_t{1} << N); ++bits) {
+      std::array<std::uint8_t, N> values{};
+      for (size_t i = 0; i < N; ++i) {
+        values[i] = static_cast<std::uint8_t>((bits >> i) & 1);
+      }
+      sort_network(values);
+      assert(std::is_sorted(values.begin(), values.end()));
+    }
+  }
+  std::uniform_int_distribution<int> key(0, 9);
+  for (size_t trial = 0; trial < 1000; ++trial) {
+    std::array<int, N> keys{};
+    std::array<size_t, N> positions{};
+    for (size_t i = 0; i < N; ++i) {
+      keys[i] = key(generator);
+      positions[i] = i;
+    }
+    auto expected = keys;
+    std::sort(expected.begin(), expected.end());
+    auto sorted = keys;
+    sort_network(sorted);
+    assert(sorted == expected);
+    // The values follow their keys, and descending order works through
+    // the comparator
+    auto kv_keys = keys;
+    sort_network(kv_keys, positions, std::greater<>{});
+    for (size_t i = 0; i < N; ++i) {
+      assert(kv_keys[i] == expected[N - 1 - i]);
+      assert(keys[positions[i]] == kv_keys[i]);
+    }
+  }
+}
+
+template <class F>
+double ns_per_call(const size_t calls, F&& f) {
+  size_t repetitions = 1;
+  while (true) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      f();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double elapsed_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    if (elapsed_ns > 5.0e7) {
+      return elapsed_ns / static_cast<double>(repetitions * calls);
+    }
+    repetitions *= 2;
+  }
+}
+
+// Each sort copies the unsorted input, so every repetition sorts the same
+// random arrays
+template <size_t N, class T>
+NEVER_INLINE void run_std_sort(const std::vector<std::array<T, N>>& input,
+                               std::vector<std::array<T, N>>& output) {
+  for (size_t i = 0; i < input.size(); ++i) {
+    output[i] = input[i];
+    std::sort(output[i].begin(), output[i].end());
+  }
+}
+
+template <size_t N, class T>
+NEVER_INLINE void run_insertion_sort(
+    const std::vector<std::array<T, N>>& input,
+    std::vector<std::array<T, N>>& output) {
+  for (size_t i = 0; i < input.size(); ++i) {
+    output[i] = input[i];
+    insertion_sort(output[i]);
+  }
+}
+
+template <size_t N, class T>
+NEVER_INLINE void run_sort_network(const std::vector<std::array<T, N>>& input,
+                                   std::vector<std::array<T, N>>& output) {
+  for (size_t i = 0; i < input.size(); ++i) {
+    output[i] = input[i];
+    sort_network(output[i]);
+  }
+}
+
+template <size_t N>
+NEVER_INLINE void run_std_sort_pairs(
+    const std::vector<std::array<std::pair<float, std::uint32_t>, N>>& input,
+    std::vector<std::array<std::pair<float, std::uint32_t>, N>>& output) {
+  for (size_t i = 0; i < input.size(); ++i) {
+    output[i] = input[i];
+    std::sort(output[i].begin(), output[i].end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+  }
+}
+
+template <size_t N>
+NEVER_INLINE void run_sort_network_pairs(
+    const std::vector<std::array<float, N>>& keys,
+    const std::vector<std::array<std::uint32_t, N>>& values,
+    std::vector<std::array<float, N>>& out_keys,
+    std::vector<std::array<std::uint32_t, N>>& out_values) {
+  for (size_t i = 0; i < keys.size(); ++i) {
+    out_keys[i] = keys[i];
+    out_values[i] = values[i];
+    sort_network(out_keys[i], out_values[i]);
+  }
+}
+
+template <size_t N>
+void benchmark(std::mt19937& generator) {
+  check_network<N>(generator);
+
+  // About 128 KiB of keys
+  const size_t count = 32768 / N;
+  std::uniform_int_distribution<std::int32_t> int_key(-1000000, 1000000);
+  std::uniform_real_distribution<float> float_key(0.0f, 1.0f);
+  std::vector<std::array<std::int32_t, N>> ints(count);
+  std::vector<std::array<float, N>> floats(count);
+  std::vector<std::array<std::uint32_t, N>> values(count);
+  std::vector<std::array<std::pair<float, std::uint32_t>, N>> pairs(count);
+  for (size_t i = 0; i < count; ++i) {
+    for (size_t j = 0; j < N; ++j) {
+      ints[i][j] = int_key(generator);
+      floats[i][j] = float_key(generator);
+      values[i][j] = static_cast<std::uint32_t>(j);
+      pairs[i][j] = {floats[i][j], values[i][j]};
+    }
+  }
+  auto ints_out = ints;
+  auto floats_out = floats;
+  auto values_out = values;
+  auto pairs_out = pairs;
+
+  std::printf("%2zu %8.1f %8.1f %8.1f   %8.1f %8.1f %8.1f   %8.1f %8.1f\n", N,
+              ns_per_call(count, [&]() { run_std_sort(ints, ints_out); }),
+              ns_per_call(count,
+                          [&]() { run_insertion_sort(ints, ints_out); }),
+              ns_per_call(count, [&]() { run_sort_network(ints, ints_out); }),
+              ns_per_call(count, [&]() { run_std_sort(floats, floats_out); }),
+              ns_per_call(count,
+                          [&]() { run_insertion_sort(floats, floats_out); }),
+              ns_per_call(count,
+                          [&]() { run_sort_network(floats, floats_out); }),
+              ns_per_call(count,
+                          [&]() { run_std_sort_pairs<N>(pairs, pairs_out); }),
+              ns_per_call(count, [&]() {
+                run_sort_network_pairs<N>(floats, values, floats_out,
+                                          values_out);
+              }));
+  for (size_t i = 0; i < count; ++i) {
+    assert(std::is_sorted(ints_out[i].begin(), ints_out[i].end()));
+    assert(floats_out[i][0] == pairs_out[i][0].first);
+    assert(values_out[i][0] == pairs_out[i][0].second);
+  }
+}
+}  // namespace
+
+int main() {
+  std::mt19937 generator(7);
+  std::printf("ns per array\n");
+  std::printf("    %-26s   %-26s   %s\n", "int32", "float",
+              "float keys with uint32 values");
+  std::printf(" N %8s %8s %8s   %8s %8s %8s   %8s %8s\n", "std", "insert",
+              "network", "std", "insert", "network", "std", "network");
+  benchmark<4>(generator);
+  benchmark<6>(generator);
+  benchmark<8>(generator);
+  benchmark<12>(generator);
+  benchmark<16>(generator);
+  benchmark<20>(generator);
+  benchmark<24>(generator);
+  benchmark<32>(generator);
+}
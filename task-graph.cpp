@@ -0,0 +1,245 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compile the code using:
+ * clang++ -std=c++17 -O2 -pthread ./task-graph.cpp
+ * g++ -std=c++17 -O2 -pthread ./task-graph.cpp
+ *
+ * Describes the steps of preparing a simulation as tasks with input and
+ * output tags, checks the levels and order task_graph computes for them, and
+ * compares running them serially and on a work_stealing_pool. The loading
+ * steps wait as if reading files, so they overlap even on a single core.
+ */
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "task_graph.hpp"
+
+// Tags of the data the tasks read and write
+struct config_tag {};
+struct mesh_tag {};
+struct initial_data_tag {};
+struct normals_tag {};
+struct volume_tag {};
+struct interpolated_tag {};
+struct report_tag {};
+
+struct state {
+  std::chrono::milliseconds io_time{};
+  size_t points = 0;
+  std::vector<double> mesh;
+  std::vector<double> initial_data;
+  std::vector<double> normals;
+  double volume = 0.0;
+  std::vector<double> interpolated;
+  double report = 0.0;
+};
+
+struct read_config {
+  using inputs = typelist<>;
+  using outputs = typelist<config_tag>;
+  void operator()(state& s) const { s.points = 1 << 16; }
+};
+
+struct load_mesh {
+  using inputs = typelist<config_tag>;
+  using outputs = typelist<mesh_tag>;
+  void operator()(state& s) const {
+    std::this_thread::sleep_for(s.io_time);
+    s.mesh.resize(s.points);
+    for (size_t i = 0; i < s.points; ++i) {
+      s.mesh[i] = std::sin(0.001 * static_cast<double>(i));
+    }
+  }
+};
+
+struct load_initial_data {
+  using inputs = typelist<config_tag>;
+  using outputs = typelist<initial_data_tag>;
+  void operator()(state& s) const {
+    std::this_thread::sleep_for(s.io_time);
+    s.initial_data.assign(s.points, 1.5);
+  }
+};
+
+struct compute_normals {
+  using inputs = typelist<mesh_tag>;
+  using outputs = typelist<normals_tag>;
+  void operator()(state& s) const {
+    s.normals.resize(s.points);
+    for (size_t i = 0; i < s.points; ++i) {
+      s.normals[i] = std::sqrt(1.0 + s.mesh[i] * s.mesh[i]);
+    }
+  }
+};
+
+struct compute_volume {
+  using inputs = typelist<mesh_tag>;
+  using outputs = typelist<volume_tag>;
+  void operator()(state& s) const {
+    s.volume = 0.0;
+    for (const double x : s.mesh) {
+      s.volume += std::abs(x);
+    }
+  }
+};
+
+struct interpolate {
+  using inputs = typelist<mesh_tag, initial_data_tag>;
+  using outputs = typelist<interpolated_tag>;
+  void operator()(state& s) const {
+    s.interpolated.resize(s.points);
+    for (size_t i = 0; i < s.points; ++i) {
+      s.interpolated[i] = s.initial_data[i] * s.mesh[i];
+    }
+  }
+};
+
+struct write_report {
+  using inputs = typelist<normals_tag, volume_tag, interpolated_tag>;
+  using outputs = typelist<report_tag>;
+  void operator()(state& s) const {
+    std::this_thread::sleep_for(s.io_time);
+    s.report = s.volume;
+    for (size_t i = 0; i < s.points; ++i) {
+      s.report += s.normals[i] * s.interpolated[i];
+    }
+  }
+};
+
+// Listed in no particular order
+using preparation =
+    task_graph<typelist<write_report, interpolate, compute_volume,
+                        compute_normals, load_initial_data, load_mesh,
+                        read_config>>;
+
+static_assert(preparation::levels == 4);
+static_assert(preparation::level[6] == 0);  // read_config
+static_assert(preparation::level[5] == 1 and preparation::level[4] == 1);
+static_assert(preparation::level[1] == 2 and preparation::level[2] == 2 and
+              preparation::level[3] == 2);
+static_assert(preparation::level[0] == 3);  // write_report
+static_assert(preparation::order[0] == 6 and preparation::order[6] == 0);
+static_assert(preparation::depends[1][5] and preparation::depends[1][4] and
+              not preparation::depends[1][3]);
+
+// A cycle does not compile:
+//   struct a { using inputs = typelist<x>; using outputs = typelist<y>; };
+//   struct b { using inputs = typelist<y>; using outputs = typelist<x>; };
+//   task_graph<typelist<a, b>> graph{};
+//   error: static assertion failed: The dependencies of the tasks of the
+//   graph form a cycle
+
+struct failing_step {
+  using inputs = typelist<>;
+  using outputs = typelist<mesh_tag>;
+  void operator()(state& /*s*/) const {
+    throw std::runtime_error("mesh file not found");
+  }
+};
+
+struct independent_step {
+  using inputs = typelist<>;
+  using outputs = typelist<volume_tag>;
+  void operator()(state& s) const { s.volume = 1.0; }
+};
+
+// Reads and writes volume_tag, so it updates the volume in place
+struct scale_volume {
+  using inputs = typelist<config_tag, volume_tag>;
+  using outputs = typelist<volume_tag>;
+  void operator()(state& s) const {
+    s.volume *= static_cast<double>(s.points);
+  }
+};
+
+using in_place = task_graph<typelist<scale_volume, read_config>>;
+static_assert(not in_place::depends[0][0] and in_place::depends[0][1]);
+static_assert(in_place::levels == 2 and in_place::order[0] == 1);
+
+template <class F>
+double milliseconds(F&& f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+int main() {
+  preparation graph{};
+  work_stealing_pool pool{3};
+  for (const auto io_time : {std::chrono::milliseconds{0},
+                             std::chrono::milliseconds{20}}) {
+    state serial{};
+    serial.io_time = io_time;
+    state parallel{};
+    parallel.io_time = io_time;
+    const double serial_ms = milliseconds([&]() { graph.run_serial(serial); });
+    const double parallel_ms =
+        milliseconds([&]() { graph.run(pool, parallel); });
+    assert(serial.report == parallel.report);
+    assert(parallel.points == 1 << 16 and parallel.volume > 0.0);
+    std::printf("I/O %3lld ms per load: serial %7.2f ms, %zu workers %7.2f "
+                "ms\n",
+                static_cast<long long>(io_time.count()), serial_ms,
+                pool.workers(), parallel_ms);
+  }
+
+  // An exception of a task is rethrown by run once its level is done
+  task_graph<typelist<failing_step, independent_step>> failing{};
+  state s{};
+  bool caught = false;
+  try {
+    failing.run(pool, s);
+  } catch (const std::runtime_error&) {
+    caught = true;
+  }
+  assert(caught);
+  assert(s.volume == 1.0);
+
+  // A task updating its input in place runs after the tasks it reads from
+  in_place scaling{};
+  scaling.run(pool, s);
+  assert(s.volume == static_cast<double>(1 << 16));
+
+  // Without workers everything runs on the calling thread
+  work_stealing_pool serial_pool{0};
+  state on_caller{};
+  graph.run(serial_pool, on_caller);
+  assert(on_caller.report > 0.0);
+}
@@ -0,0 +1,303 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "typelist.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace task_graph_detail {
+template <class T, class List>
+struct contains;
+
+template <class T, class... Ts>
+struct contains<T, typelist<Ts...>>
+    : std::bool_constant<(std::is_same_v<T, Ts> or ...)> {};
+
+template <class List1, class List2>
+struct intersects;
+
+template <class... Ts, class List2>
+struct intersects<typelist<Ts...>, List2>
+    : std::bool_constant<(contains<Ts, List2>::value or ...)> {};
+
+template <size_t N>
+using matrix = std::array<std::array<bool, N>, N>;
+
+// A task that reads and writes the same tag updates it in place and does not
+// depend on itself
+template <size_t N>
+constexpr matrix<N> without_diagonal(matrix<N> depends) {
+  for (size_t i = 0; i < N; ++i) {
+    depends[i][i] = false;
+  }
+  return depends;
+}
+
+// The level of a task is 0 if it has no dependencies and otherwise one more
+// than the highest level of the tasks it depends on, so the tasks of a level
+// only depend on tasks of lower levels. Each sweep raises the lowest level on
+// any cycle by at least one, so after N sweeps a level of N or more means
+// there is a cycle.
+template <size_t N>
+constexpr std::array<size_t, N> levels(const matrix<N>& depends) {
+  std::array<size_t, N> result{};
+  for (size_t sweep = 0; sweep < N; ++sweep) {
+    for (size_t i = 0; i < N; ++i) {
+      for (size_t j = 0; j < N; ++j) {
+        if (i != j and depends[i][j] and result[j] + 1 > result[i]) {
+          result[i] = result[j] + 1;
+        }
+      }
+    }
+  }
+  return result;
+}
+
+template <size_t N>
+constexpr bool has_cycle(const std::array<size_t, N>& level) {
+  for (size_t i = 0; i < N; ++i) {
+    if (level[i] >= N) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <size_t N>
+constexpr size_t level_count(const std::array<size_t, N>& level) {
+  size_t result = 0;
+  for (size_t i = 0; i < N; ++i) {
+    result = level[i] + 1 > result ? level[i] + 1 : result;
+  }
+  return result;
+}
+
+// The task indices sorted by level, keeping the declaration order within a
+// level, which is a topological order
+template <size_t N>
+constexpr std::array<size_t, N> order(const std::array<size_t, N>& level) {
+  std::array<size_t, N> result{};
+  size_t next = 0;
+  for (size_t l = 0; l < N; ++l) {
+    for (size_t i = 0; i < N; ++i) {
+      if (level[i] == l) {
+        result[next++] = i;
+      }
+    }
+  }
+  return result;
+}
+
+template <size_t N>
+constexpr size_t level_begin(const std::array<size_t, N>& level,
+                             const size_t l) {
+  size_t result = 0;
+  for (size_t i = 0; i < N; ++i) {
+    result += level[i] < l ? 1 : 0;
+  }
+  return result;
+}
+}  // namespace task_graph_detail
+
+template <class TaskList>
+class task_graph;
+
+/*!
+ * \brief Runs the tasks `Tasks...` in an order, and with the parallelism,
+ * implied by the data they declare to read and write.
+ *
+ * Each task declares the tags of the data it reads as the typelist
+ * `inputs` and of the data it writes as the typelist `outputs`, and is
+ * called with the arguments passed to run(). A task depends on the tasks
+ * that output any of its inputs. Tags that no task outputs are inputs of the
+ * whole graph. From this the dependencies, the level of each task and a
+ * topological order are computed at compile time, and a cycle or a tag
+ * output by two tasks is a compile time error. A task may list a tag in both
+ * its inputs and outputs to update that data in place, which does not make
+ * it depend on itself.
+ *
+ * The tasks of a level do not depend on each other, so run() hands each
+ * level to a work_stealing_pool as one batch and waits for it before the
+ * next. The batch of each level is an array of jobs generated by a pack
+ * expansion over the indices of its tasks, so no dispatch happens at run
+ * time beyond calling the jobs.
+ *
+ * \example
+ * \code
+ * struct load_mesh {
+ *   using inputs = typelist<>;
+ *   using outputs = typelist<mesh_tag>;
+ *   void operator()(state& s) const { s.mesh = load(s.path); }
+ * };
+ * struct compute_normals {
+ *   using inputs = typelist<mesh_tag>;
+ *   using outputs = typelist<normals_tag>;
+ *   void operator()(state& s) const { s.normals = normals(s.mesh); }
+ * };
+ * task_graph<typelist<compute_normals, load_mesh>> graph{};
+ * graph.run(pool, s);  // load_mesh, then compute_normals
+ * \endcode
+ *
+ * \note Tasks of the same level run concurrently on the same arguments, so
+ * they must only write the data of their outputs.
+ */
+template <class... Tasks>
+class task_graph<typelist<Tasks...>> {
+  static constexpr size_t size_ = sizeof...(Tasks);
+
+  template <class Task>
+  static constexpr std::array<bool, size_> depends_row = {
+      task_graph_detail::intersects<typename Task::inputs,
+                                    typename Tasks::outputs>::value...};
+
+  template <class Task>
+  static constexpr std::array<bool, size_> output_overlap_row = {
+      task_graph_detail::intersects<typename Task::outputs,
+                                    typename Tasks::outputs>::value...};
+
+  static constexpr bool any_shared_output() {
+    constexpr task_graph_detail::matrix<size_> overlap = {
+        output_overlap_row<Tasks>...};
+    for (size_t i = 0; i < size_; ++i) {
+      for (size_t j = 0; j < size_; ++j) {
+        if (i != j and overlap[i][j]) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  static_assert(not any_shared_output(),
+                "Two tasks of the graph declare the same output tag");
+
+ public:
+  /// `depends[i][j]` is whether task `i` reads an output of task `j`, with
+  /// `depends[i][i]` always false
+  static constexpr task_graph_detail::matrix<size_> depends =
+      task_graph_detail::without_diagonal(
+          task_graph_detail::matrix<size_>{depends_row<Tasks>...});
+
+  static constexpr bool has_cycle =
+      task_graph_detail::has_cycle(task_graph_detail::levels(depends));
+  static_assert(not has_cycle,
+                "The dependencies of the tasks of the graph form a cycle");
+
+  /// The level of each task; the tasks of a level only depend on tasks of
+  /// lower levels
+  static constexpr std::array<size_t, size_> level =
+      has_cycle ? std::array<size_t, size_>{}
+                : task_graph_detail::levels(depends);
+
+  static constexpr size_t levels = task_graph_detail::level_count(level);
+
+  /// The task indices in an order that respects the dependencies
+  static constexpr std::array<size_t, size_> order =
+      task_graph_detail::order(level);
+
+  task_graph() = default;
+
+  explicit task_graph(Tasks... tasks) : tasks_(std::move(tasks)...) {}
+
+  /// Calls the tasks one after another in `order` on the calling thread
+  template <class... Args>
+  void run_serial(Args&... args) {
+    run_serial(std::make_index_sequence<size_>{}, args...);
+  }
+
+  /// Calls the tasks on `pool`, one level after another
+  template <class... Args>
+  void run(work_stealing_pool& pool, Args&... args) {
+    closure<Args...> call{this, {args...}};
+    run_levels(pool, call, std::make_index_sequence<levels>{});
+  }
+
+  template <size_t I>
+  auto& get() {
+    return std::get<I>(tasks_);
+  }
+
+ private:
+  template <class... Args>
+  struct closure {
+    task_graph* graph;
+    std::tuple<Args&...> args;
+  };
+
+  template <size_t I, class Closure>
+  static void call(void* const argument) {
+    auto& c = *static_cast<Closure*>(argument);
+    std::apply(
+        [&c](auto&... args) { std::get<I>(c.graph->tasks_)(args...); },
+        c.args);
+  }
+
+  template <class... Args, size_t... Positions>
+  void run_serial(std::index_sequence<Positions...> /*meta*/,
+                  Args&... args) {
+    static_cast<void>(std::initializer_list<char>{
+        (static_cast<void>(std::get<order[Positions]>(tasks_)(args...)),
+         '0')...});
+  }
+
+  template <class Closure, size_t... Levels>
+  static void run_levels(work_stealing_pool& pool, Closure& call,
+                         std::index_sequence<Levels...> /*meta*/) {
+    static_cast<void>(std::initializer_list<char>{
+        (run_level<task_graph_detail::level_begin(level, Levels)>(
+             pool, call,
+             std::make_index_sequence<
+                 task_graph_detail::level_begin(level, Levels + 1) -
+                 task_graph_detail::level_begin(level, Levels)>{}),
+         '0')...});
+  }
+
+  template <size_t Begin, class Closure, size_t... Positions>
+  static void run_level(work_stealing_pool& pool, Closure& c,
+                        std::index_sequence<Positions...> /*meta*/) {
+    const work_stealing_pool::job jobs[] = {
+        {&call<order[Begin + Positions], Closure>, &c}...};
+    if (sizeof...(Positions) == 1) {
+      // Nothing to run concurrently
+      jobs[0].function(jobs[0].argument);
+    } else {
+      pool.run(jobs, sizeof...(Positions));
+    }
+  }
+
+  std::tuple<Tasks...> tasks_;
+};
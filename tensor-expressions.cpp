@@ -0,0 +1,579 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compile the code using:
+ * clang++ -std=c++17 -O3 ./tensor-expressions.cpp
+ * g++ -std=c++17 -O3 ./tensor-expressions.cpp
+ */
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "for_constexpr.hpp"
+
+/*!
+ * \brief A placeholder for a tensor index.
+ *
+ * `Id` names the index and `Bounds` is the range it loops over, either a
+ * `for_bounds` or a `for_symm_lower`/`for_symm_upper`. Unlike in a plain
+ * for_constexpr loop, the first template parameter of `for_symm_lower` and
+ * `for_symm_upper` is the `Id` of the index being symmetrized over, not the
+ * position of its loop, since the loop order is chosen when the expression is
+ * evaluated.
+ *
+ * \example
+ * \code
+ * constexpr tensor_index<'i', for_bounds<0, 3>> i{};
+ * constexpr tensor_index<'j', for_symm_upper<'i', 3>> j{};
+ * \endcode
+ */
+template <size_t Id, class Bounds>
+struct tensor_index {
+  static constexpr size_t id = Id;
+  using bounds = Bounds;
+};
+
+namespace tensor_expression_detail {
+// The values of the indices that have already been looped over
+template <size_t Id, size_t Value>
+struct bound_index {};
+
+template <class... BoundIndices>
+struct index_env : BoundIndices... {};
+
+template <size_t Id, size_t Value>
+constexpr size_t value_of(bound_index<Id, Value> /*meta*/) {
+  return Value;
+}
+
+template <size_t Id, size_t Value>
+constexpr std::true_type is_bound(bound_index<Id, Value> /*meta*/);
+template <size_t Id>
+constexpr std::false_type is_bound(...);
+
+template <size_t Id, size_t Value>
+constexpr size_t value_or_zero(bound_index<Id, Value> /*meta*/) {
+  return Value;
+}
+template <size_t Id>
+constexpr size_t value_or_zero(...) {
+  return 0;
+}
+
+template <class Env, class... BoundIndices>
+struct extend_env;
+
+template <class... Existing, class... BoundIndices>
+struct extend_env<index_env<Existing...>, BoundIndices...> {
+  using type = index_env<Existing..., BoundIndices...>;
+};
+
+// Index lists are std::tuples of tensor_index types
+template <class Index, class IndexList>
+struct contains;
+
+template <class Index, class... Indices>
+struct contains<Index, std::tuple<Indices...>>
+    : std::integral_constant<bool, (std::is_same<Index, Indices>::value or
+                                    ...)> {};
+
+template <size_t Id, class... Indices>
+constexpr size_t position_of_id(std::tuple<Indices...> /*meta*/) {
+  size_t position = 0;
+  for (const size_t id : {Indices::id...}) {
+    if (id == Id) {
+      return position;
+    }
+    ++position;
+  }
+  return position;
+}
+
+// The number of indices in `Indices` named `Id`
+template <size_t Id, class... Indices>
+constexpr size_t count_of_id() {
+  return ((Indices::id == Id ? size_t{1} : size_t{0}) + ... + size_t{0});
+}
+
+template <bool Keep, class Index>
+using keep_if = std::conditional_t<Keep, std::tuple<Index>, std::tuple<>>;
+
+// Indices of `List1` that are also in `List2`
+template <class List1, class List2>
+struct intersection;
+
+template <class... Indices, class List2>
+struct intersection<std::tuple<Indices...>, List2> {
+  using type = decltype(std::tuple_cat(
+      keep_if<contains<Indices, List2>::value, Indices>{}...));
+};
+
+// Indices of `List1` that are not in `List2`
+template <class List1, class List2>
+struct difference;
+
+template <class... Indices, class List2>
+struct difference<std::tuple<Indices...>, List2> {
+  using type = decltype(std::tuple_cat(
+      keep_if<not contains<Indices, List2>::value, Indices>{}...));
+};
+
+template <class List1, class List2>
+struct same_indices;
+
+template <class... Indices1, class... Indices2>
+struct same_indices<std::tuple<Indices1...>, std::tuple<Indices2...>>
+    : std::integral_constant<
+          bool,
+          sizeof...(Indices1) == sizeof...(Indices2) and
+              (contains<Indices1, std::tuple<Indices2...>>::value and ...)> {};
+
+// Turn the bounds of `Index` into bounds for a for_constexpr loop over
+// `Nest`. Indices that are symmetrized over an index that is already bound in
+// `Env` get a for_bounds since the value is known, and those symmetrized over
+// an earlier loop in `Nest` get the position of that loop.
+template <class Bounds, class Env, class Nest>
+struct resolve_bounds;
+
+template <size_t Lower, size_t Upper, class Env, class Nest>
+struct resolve_bounds<for_bounds<Lower, Upper>, Env, Nest> {
+  using type = for_bounds<Lower, Upper>;
+};
+
+template <size_t Id, size_t Lower, ssize_t Offset, class Env, class Nest>
+struct resolve_bounds<for_symm_lower<Id, Lower, Offset>, Env, Nest> {
+  static constexpr bool bound_in_env =
+      decltype(is_bound<Id>(std::declval<Env>()))::value;
+  using type = std::conditional_t<
+      bound_in_env,
+      for_bounds<Lower, static_cast<size_t>(
+                            static_cast<ssize_t>(value_or_zero<Id>(Env{})) +
+                            Offset)>,
+      for_symm_lower<position_of_id<Id>(Nest{}), Lower, Offset>>;
+};
+
+template <size_t Id, size_t Upper, class Env, class Nest>
+struct resolve_bounds<for_symm_upper<Id, Upper>, Env, Nest> {
+  static constexpr bool bound_in_env =
+      decltype(is_bound<Id>(std::declval<Env>()))::value;
+  using type = std::conditional_t<
+      bound_in_env,
+      for_bounds<value_or_zero<Id>(Env{}), Upper>,
+      for_symm_upper<position_of_id<Id>(Nest{}), Upper>>;
+};
+
+template <class Index, class Env, class Nest>
+using resolved_bounds_t =
+    typename resolve_bounds<typename Index::bounds, Env, Nest>::type;
+
+// Loop over `Indices` (with the outer indices bound in `Env`) in a single
+// for_constexpr nest, calling `f` with the extended environment.
+template <class Env, class... Indices, class F>
+ALWAYS_INLINE constexpr void loop_over(std::tuple<Indices...> /*meta*/,
+                                       F&& f) {
+  for_constexpr<resolved_bounds_t<Indices, Env, std::tuple<Indices...>>...>(
+      [&f](auto... values) {
+        f(typename extend_env<
+            Env, bound_index<Indices::id, decltype(values)::value>...>::type{});
+      });
+}
+
+template <class Env, class F>
+ALWAYS_INLINE constexpr void loop_over(std::tuple<> /*meta*/, F&& f) {
+  f(Env{});
+}
+
+// Sum the value returned by `f` over the `Summed` indices.
+template <class T, class Env, class Summed, class F>
+ALWAYS_INLINE constexpr T sum_over(F&& f) {
+  if constexpr (std::tuple_size<Summed>::value == 0) {
+    return f(Env{});
+  } else {
+    T result{0};
+    loop_over<Env>(Summed{}, [&result, &f](auto env) { result += f(env); });
+    return result;
+  }
+}
+
+template <class Array>
+ALWAYS_INLINE constexpr decltype(auto) component(Array& array) {
+  return array;
+}
+
+template <class Array, class... Rest>
+ALWAYS_INLINE constexpr decltype(auto) component(Array& array,
+                                                 const size_t first,
+                                                 const Rest... rest) {
+  return component(array[first], rest...);
+}
+
+template <class Array>
+struct value_type {
+  using type = Array;
+};
+
+template <class T, size_t N>
+struct value_type<std::array<T, N>> {
+  using type = typename value_type<T>::type;
+};
+}  // namespace tensor_expression_detail
+
+// Base class used to detect tensor expressions
+struct tensor_expression {};
+
+template <class T>
+constexpr bool is_tensor_expression_v =
+    std::is_base_of<tensor_expression, std::decay_t<T>>::value;
+
+/*!
+ * \brief A component of a (possibly nested) `std::array` indexed by
+ * `tensor_index`es. Assigning an expression to it evaluates the expression in a
+ * single fused for_constexpr nest over the indices.
+ */
+template <class Array, class... Indices>
+struct indexed_tensor : tensor_expression {
+  // Compiling `tensor(a)(i, i)` was verified to fail this check
+  static_assert(
+      ((tensor_expression_detail::count_of_id<Indices::id, Indices...>() ==
+        1) and
+       ...),
+      "Repeated indices in a single tensor are not supported");
+
+  using free_indices = std::tuple<Indices...>;
+  using value_type = typename tensor_expression_detail::value_type<
+      std::remove_const_t<Array>>::type;
+
+  constexpr explicit indexed_tensor(Array& a) : array(a) {}
+  constexpr indexed_tensor(const indexed_tensor& /*rhs*/) = default;
+
+  Array& array;
+
+  template <class Env>
+  ALWAYS_INLINE constexpr value_type evaluate(Env env) const {
+    return tensor_expression_detail::component(
+        array, tensor_expression_detail::value_of<Indices::id>(env)...);
+  }
+
+  template <class Expression,
+            std::enable_if_t<is_tensor_expression_v<Expression>>* = nullptr>
+  ALWAYS_INLINE constexpr indexed_tensor& operator=(
+      const Expression& expression) {
+    static_assert(not std::is_const<Array>::value,
+                  "Cannot assign to a const tensor");
+    static_assert(tensor_expression_detail::same_indices<
+                      free_indices, typename Expression::free_indices>::value,
+                  "The free indices of the left and right hand side of an "
+                  "assignment must be the same");
+    tensor_expression_detail::loop_over<
+        tensor_expression_detail::index_env<>>(
+        free_indices{}, [this, &expression](auto env) {
+          tensor_expression_detail::component(
+              array, tensor_expression_detail::value_of<Indices::id>(env)...) =
+              expression.evaluate(env);
+        });
+    return *this;
+  }
+
+  // Needed since otherwise the implicit copy assignment is a better match
+  ALWAYS_INLINE constexpr indexed_tensor& operator=(
+      const indexed_tensor& expression) {
+    return operator=<indexed_tensor>(expression);
+  }
+};
+
+template <class Array>
+struct tensor_ref {
+  Array& array;
+
+  template <class... Indices>
+  constexpr indexed_tensor<Array, Indices...> operator()(
+      Indices... /*indices*/) const {
+    return indexed_tensor<Array, Indices...>{array};
+  }
+};
+
+/// Wrap a (nested) `std::array` so it can be indexed by `tensor_index`es
+template <class Array>
+constexpr tensor_ref<Array> tensor(Array& array) {
+  return {array};
+}
+
+template <class Lhs, class Rhs, class Op>
+struct tensor_sum : tensor_expression {
+  static_assert(tensor_expression_detail::same_indices<
+                    typename Lhs::free_indices,
+                    typename Rhs::free_indices>::value,
+                "The free indices of both operands of + and - must be the same");
+
+  using free_indices = typename Lhs::free_indices;
+  using value_type = std::common_type_t<typename Lhs::value_type,
+                                        typename Rhs::value_type>;
+
+  Lhs lhs;
+  Rhs rhs;
+
+  template <class Env>
+  ALWAYS_INLINE constexpr value_type evaluate(Env env) const {
+    return Op{}(lhs.evaluate(env), rhs.evaluate(env));
+  }
+};
+
+/*!
+ * \brief The product of two tensor expressions. Indices that appear in both
+ * operands are summed over (contracted) when the product is evaluated.
+ */
+template <class Lhs, class Rhs>
+struct tensor_product : tensor_expression {
+  using summed_indices = typename tensor_expression_detail::intersection<
+      typename Lhs::free_indices, typename Rhs::free_indices>::type;
+  using free_indices = decltype(std::tuple_cat(
+      typename tensor_expression_detail::difference<
+          typename Lhs::free_indices, summed_indices>::type{},
+      typename tensor_expression_detail::difference<
+          typename Rhs::free_indices, summed_indices>::type{}));
+  using value_type = std::common_type_t<typename Lhs::value_type,
+                                        typename Rhs::value_type>;
+
+  Lhs lhs;
+  Rhs rhs;
+
+  template <class Env>
+  ALWAYS_INLINE constexpr value_type evaluate(Env /*env*/) const {
+    return tensor_expression_detail::sum_over<value_type, Env, summed_indices>(
+        [this](auto env) { return lhs.evaluate(env) * rhs.evaluate(env); });
+  }
+};
+
+template <class T>
+struct tensor_scalar : tensor_expression {
+  using free_indices = std::tuple<>;
+  using value_type = T;
+
+  T value;
+
+  template <class Env>
+  ALWAYS_INLINE constexpr value_type evaluate(Env /*env*/) const {
+    return value;
+  }
+};
+
+template <class Lhs, class Rhs,
+          std::enable_if_t<is_tensor_expression_v<Lhs> and
+                           is_tensor_expression_v<Rhs>>* = nullptr>
+constexpr tensor_sum<Lhs, Rhs, std::plus<>> operator+(const Lhs& lhs,
+                                                      const Rhs& rhs) {
+  return {{}, lhs, rhs};
+}
+
+template <class Lhs, class Rhs,
+          std::enable_if_t<is_tensor_expression_v<Lhs> and
+                           is_tensor_expression_v<Rhs>>* = nullptr>
+constexpr tensor_sum<Lhs, Rhs, std::minus<>> operator-(const Lhs& lhs,
+                                                       const Rhs& rhs) {
+  return {{}, lhs, rhs};
+}
+
+template <class Lhs, class Rhs,
+          std::enable_if_t<is_tensor_expression_v<Lhs> and
+                           is_tensor_expression_v<Rhs>>* = nullptr>
+constexpr tensor_product<Lhs, Rhs> operator*(const Lhs& lhs, const Rhs& rhs) {
+  return {{}, lhs, rhs};
+}
+
+template <class T, class Rhs,
+          std::enable_if_t<std::is_arithmetic<T>::value and
+                           is_tensor_expression_v<Rhs>>* = nullptr>
+constexpr tensor_product<tensor_scalar<T>, Rhs> operator*(const T& lhs,
+                                                          const Rhs& rhs) {
+  return {{}, {{}, lhs}, rhs};
+}
+
+namespace {
+constexpr size_t dim = 3;
+using matrix = std::array<std::array<double, dim>, dim>;
+
+using index_i = tensor_index<'i', for_bounds<0, dim>>;
+using index_j = tensor_index<'j', for_bounds<0, dim>>;
+using index_k = tensor_index<'k', for_bounds<0, dim>>;
+constexpr index_i i{};
+constexpr index_j j{};
+constexpr index_k k{};
+constexpr tensor_index<'l', for_bounds<0, dim>> l{};
+
+using contraction = decltype(tensor(std::declval<matrix&>())(i, k) *
+                             tensor(std::declval<matrix&>())(k, j));
+static_assert(std::is_same<contraction::free_indices,
+                           std::tuple<index_i, index_j>>::value,
+              "The free indices of A(i,k)*B(k,j) should be (i, j)");
+static_assert(
+    std::is_same<contraction::summed_indices, std::tuple<index_k>>::value,
+    "The summed indices of A(i,k)*B(k,j) should be (k)");
+
+matrix make_matrix(const double offset) {
+  matrix result{};
+  for (size_t a = 0; a < dim; ++a) {
+    for (size_t b = 0; b < dim; ++b) {
+      result[a][b] = offset + static_cast<double>(a * dim + b);
+    }
+  }
+  return result;
+}
+
+void contraction_example() {
+  const matrix a = make_matrix(1.0);
+  const matrix b = make_matrix(-4.0);
+  const matrix d = make_matrix(0.5);
+  const std::array<double, dim> v{{1.0, 2.0, 3.0}};
+
+  matrix c{};
+  tensor(c)(i, j) = tensor(a)(i, k) * tensor(b)(k, j) + tensor(d)(i, j);
+  for (size_t m = 0; m < dim; ++m) {
+    for (size_t n = 0; n < dim; ++n) {
+      double expected = d[m][n];
+      for (size_t p = 0; p < dim; ++p) {
+        expected += a[m][p] * b[p][n];
+      }
+      assert(c[m][n] == expected);
+    }
+  }
+
+  // Chained contractions and scalars never create temporaries
+  matrix e{};
+  tensor(e)(i, j) = 2.0 * tensor(a)(i, k) * tensor(b)(k, l) * tensor(d)(l, j) -
+                    tensor(d)(j, i);
+  for (size_t m = 0; m < dim; ++m) {
+    for (size_t n = 0; n < dim; ++n) {
+      double expected = 0.0;
+      for (size_t p = 0; p < dim; ++p) {
+        for (size_t q = 0; q < dim; ++q) {
+          expected += 2.0 * a[m][p] * b[p][q] * d[q][n];
+        }
+      }
+      assert(e[m][n] == expected - d[n][m]);
+    }
+  }
+
+  // Full contraction to a vector
+  std::array<double, dim> w{};
+  tensor(w)(i) = tensor(a)(i, k) * tensor(v)(k);
+  for (size_t m = 0; m < dim; ++m) {
+    assert(w[m] == a[m][0] * v[0] + a[m][1] * v[1] + a[m][2] * v[2]);
+  }
+
+  // Only the upper triangle of a symmetric result is computed
+  constexpr tensor_index<'s', for_symm_upper<'i', dim>> s{};
+  matrix f{};
+  tensor(f)(i, s) = tensor(a)(i, k) * tensor(a)(s, k);
+  for (size_t m = 0; m < dim; ++m) {
+    for (size_t n = 0; n < dim; ++n) {
+      const double expected =
+          a[m][0] * a[n][0] + a[m][1] * a[n][1] + a[m][2] * a[n][2];
+      assert(f[m][n] == (n >= m ? expected : 0.0));
+    }
+  }
+  std::cout << "Tensor expression checks passed\n";
+}
+
+// C(i,j) = A(i,k) B(k,j) + D(i,j) as two for_constexpr passes with a
+// temporary in between.
+template <size_t Dim>
+void unfused(std::array<std::array<double, Dim>, Dim>& c,
+             const std::array<std::array<double, Dim>, Dim>& a,
+             const std::array<std::array<double, Dim>, Dim>& b,
+             const std::array<std::array<double, Dim>, Dim>& d) {
+  std::array<std::array<double, Dim>, Dim> temp{};
+  for_constexpr<for_bounds<0, Dim>, for_bounds<0, Dim>, for_bounds<0, Dim>>(
+      [&temp, &a, &b](auto ii, auto jj, auto kk) {
+        temp[ii][jj] += a[ii][kk] * b[kk][jj];
+      });
+  for_constexpr<for_bounds<0, Dim>, for_bounds<0, Dim>>(
+      [&c, &temp, &d](auto ii, auto jj) { c[ii][jj] = temp[ii][jj] + d[ii][jj]; });
+}
+
+template <size_t Dim>
+void fused(std::array<std::array<double, Dim>, Dim>& c,
+           const std::array<std::array<double, Dim>, Dim>& a,
+           const std::array<std::array<double, Dim>, Dim>& b,
+           const std::array<std::array<double, Dim>, Dim>& d) {
+  constexpr tensor_index<'i', for_bounds<0, Dim>> ii{};
+  constexpr tensor_index<'j', for_bounds<0, Dim>> jj{};
+  constexpr tensor_index<'k', for_bounds<0, Dim>> kk{};
+  tensor(c)(ii, jj) = tensor(a)(ii, kk) * tensor(b)(kk, jj) + tensor(d)(ii, jj);
+}
+
+template <size_t Dim, class F>
+double time_per_call(F&& f, const size_t number_of_calls) {
+  std::array<std::array<double, Dim>, Dim> a{};
+  std::array<std::array<double, Dim>, Dim> b{};
+  std::array<std::array<double, Dim>, Dim> c{};
+  std::array<std::array<double, Dim>, Dim> d{};
+  for (size_t m = 0; m < Dim; ++m) {
+    for (size_t n = 0; n < Dim; ++n) {
+      a[m][n] = 1.0 / static_cast<double>(m + n + 1);
+      b[m][n] = 0.5 * a[m][n];
+      d[m][n] = static_cast<double>(m);
+    }
+  }
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t call = 0; call < number_of_calls; ++call) {
+    f(c, a, b, d);
+    // Feed the result back in so the calls cannot be hoisted out of the loop
+    std::swap(c, d);
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  volatile double sink = d[Dim - 1][Dim - 1];
+  static_cast<void>(sink);
+  return std::chrono::duration<double, std::nano>(stop - start).count() /
+         static_cast<double>(number_of_calls);
+}
+
+template <size_t Dim>
+void benchmark(const size_t number_of_calls) {
+  std::cout << "Dim " << Dim << ": unfused "
+            << time_per_call<Dim>(unfused<Dim>, number_of_calls)
+            << " ns/call, fused "
+            << time_per_call<Dim>(fused<Dim>, number_of_calls)
+            << " ns/call\n";
+}
+}  // namespace
+
+int main() {
+  contraction_example();
+  benchmark<2>(10000000);
+  benchmark<3>(10000000);
+  benchmark<4>(10000000);
+}
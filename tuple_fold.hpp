@@ -0,0 +1,270 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "instrumentation.hpp"
+
+namespace tuple_impl_detail {
+// Elements are accessed with an unqualified `get` so that the implementations
+// also work for other tuple-like types that provide `get`
+using std::get;
+
+template <bool ReverseIteration, typename Tuple, typename N_aryOp,
+          typename... Args, size_t... Is>
+constexpr void tuple_fold_impl(
+    const Tuple& tupull, N_aryOp&& op,
+    std::index_sequence<Is...> /*meta*/,
+    Args&... args) noexcept(noexcept(static_cast<void>(std::initializer_list<char>{
+    (static_cast<void>(
+         op(get<(ReverseIteration ? sizeof...(Is) - 1 - Is : Is)>(
+                tupull),
+            args...)),
+     '0')...}))) {
+  TMPL_INSTRUMENT_TAG(instrumentation::call_site_tag<
+                      instrumentation::tuple_fold_site,
+                      Tuple, std::decay_t<N_aryOp>>);
+  TMPL_INSTRUMENT_CALL();
+  constexpr size_t tuple_size = sizeof...(Is);
+  static_cast<void>(std::initializer_list<char>{
+      (static_cast<void>(TMPL_INSTRUMENT_ELEMENT(
+           (ReverseIteration ? tuple_size - 1 - Is : Is),
+           op(get<(ReverseIteration ? tuple_size - 1 - Is : Is)>(tupull),
+              args...))),
+       '0')...});
+}
+
+template <bool ReverseIteration, typename Tuple, typename N_aryOp,
+          typename... Args, size_t... Is>
+constexpr void tuple_counted_fold_impl(
+    const Tuple& tupull, N_aryOp&& op,
+    std::index_sequence<Is...> /*meta*/,
+    Args&... args) noexcept(noexcept(static_cast<void>(std::initializer_list<char>{
+    (static_cast<void>(
+         op(get<(ReverseIteration ? sizeof...(Is) - 1 - Is : Is)>(
+                tupull),
+            (ReverseIteration ? sizeof...(Is) - 1 - Is : Is), args...)),
+     '0')...}))) {
+  TMPL_INSTRUMENT_TAG(instrumentation::call_site_tag<
+                      instrumentation::tuple_counted_fold_site,
+                      Tuple, std::decay_t<N_aryOp>>);
+  TMPL_INSTRUMENT_CALL();
+  constexpr size_t tuple_size = sizeof...(Is);
+  static_cast<void>(std::initializer_list<char>{
+      (static_cast<void>(TMPL_INSTRUMENT_ELEMENT(
+           (ReverseIteration ? tuple_size - 1 - Is : Is),
+           op(get<(ReverseIteration ? tuple_size - 1 - Is : Is)>(tupull),
+              (ReverseIteration ? tuple_size - 1 - Is : Is), args...))),
+       '0')...});
+}
+
+template <bool ReverseIteration, typename Tuple, typename N_aryOp,
+          typename... Args, size_t... Is>
+constexpr inline void tuple_transform_impl(
+    const Tuple& tupull, N_aryOp&& op,
+    std::index_sequence<Is...> /*meta*/,
+    Args&... args) noexcept(noexcept(static_cast<void>(std::initializer_list<char>{
+    (static_cast<void>(op(
+         get<(ReverseIteration ? sizeof...(Is) - 1 - Is : Is)>(
+             tupull),
+         std::integral_constant<
+             size_t, (ReverseIteration ? sizeof...(Is) - 1 - Is : Is)>{},
+         args...)),
+     '0')...}))) {
+  TMPL_INSTRUMENT_TAG(instrumentation::call_site_tag<
+                      instrumentation::tuple_transform_site,
+                      Tuple, std::decay_t<N_aryOp>>);
+  TMPL_INSTRUMENT_CALL();
+  constexpr size_t tuple_size = sizeof...(Is);
+  static_cast<void>(std::initializer_list<char>{(
+      static_cast<void>(TMPL_INSTRUMENT_ELEMENT(
+          (ReverseIteration ? tuple_size - 1 - Is : Is),
+          op(get<(ReverseIteration ? tuple_size - 1 - Is : Is)>(tupull),
+             std::integral_constant<size_t, (ReverseIteration
+                                                 ? tuple_size - 1 - Is
+                                                 : Is)>{},
+             args...))),
+      '0')...});
+}
+}  // namespace tuple_impl_detail
+
+template <bool ReverseIteration = false, typename... Elements, typename N_aryOp,
+          typename... Args>
+constexpr void tuple_fold(
+    const std::tuple<Elements...>& tuple, N_aryOp&& op,
+    Args&&... args) noexcept(noexcept(tuple_impl_detail::
+                                          tuple_fold_impl<ReverseIteration>(
+                                              tuple, std::forward<N_aryOp>(op),
+                                              std::make_index_sequence<
+                                                  sizeof...(Elements)>{},
+                                              args...))) {
+  tuple_impl_detail::tuple_fold_impl<ReverseIteration>(
+      tuple, std::forward<N_aryOp>(op),
+      std::make_index_sequence<sizeof...(Elements)>{}, args...);
+}
+
+template <bool ReverseIteration = false, typename... Elements, typename N_aryOp,
+          typename... Args>
+constexpr void tuple_counted_fold(
+    const std::tuple<Elements...>& tuple, N_aryOp&& op,
+    Args&&... args) noexcept(noexcept(tuple_impl_detail::
+                                          tuple_counted_fold_impl<
+                                              ReverseIteration>(
+                                              tuple, std::forward<N_aryOp>(op),
+                                              std::make_index_sequence<
+                                                  sizeof...(Elements)>{},
+                                              args...))) {
+  tuple_impl_detail::tuple_counted_fold_impl<ReverseIteration>(
+      tuple, std::forward<N_aryOp>(op),
+      std::make_index_sequence<sizeof...(Elements)>{}, args...);
+}
+
+template <bool ReverseIteration = false, typename... Elements, typename N_aryOp,
+          typename... Args>
+constexpr void tuple_transform(
+    const std::tuple<Elements...>& tuple, N_aryOp&& op,
+    Args&&... args) noexcept(noexcept(tuple_impl_detail::
+                                          tuple_transform_impl<
+                                              ReverseIteration>(
+                                              tuple, std::forward<N_aryOp>(op),
+                                              std::make_index_sequence<
+                                                  sizeof...(Elements)>{},
+                                              args...))) {
+  tuple_impl_detail::tuple_transform_impl<ReverseIteration>(
+      tuple, std::forward<N_aryOp>(op),
+      std::make_index_sequence<sizeof...(Elements)>{}, args...);
+}
+
+namespace tuple_impl_detail {
+template <size_t Size>
+using reduce_size = std::integral_constant<size_t, (Size < 2 ? Size : 2)>;
+
+template <size_t Begin, size_t End, typename Tuple, typename Combine,
+          typename T>
+constexpr T tuple_reduce_impl(const Tuple& /*tupull*/, Combine& /*combine*/,
+                              const T& identity,
+                              reduce_size<0> /*meta*/) {
+  return identity;
+}
+
+template <size_t Begin, size_t End, typename Tuple, typename Combine,
+          typename T>
+constexpr T tuple_reduce_impl(const Tuple& tupull, Combine& /*combine*/,
+                              const T& /*identity*/,
+                              reduce_size<1> /*meta*/) {
+  return static_cast<T>(get<Begin>(tupull));
+}
+
+// Combines the reductions of the two halves, so that the reductions of the
+// left and right subtrees do not depend on each other
+template <size_t Begin, size_t End, typename Tuple, typename Combine,
+          typename T>
+constexpr T tuple_reduce_impl(const Tuple& tupull, Combine& combine,
+                              const T& identity,
+                              reduce_size<2> /*meta*/) {
+  constexpr size_t middle = Begin + (End - Begin) / 2;
+  return combine(
+      tuple_reduce_impl<Begin, middle>(tupull, combine, identity,
+                                       reduce_size<middle - Begin>{}),
+      tuple_reduce_impl<middle, End>(tupull, combine, identity,
+                                     reduce_size<End - middle>{}));
+}
+
+// A sum together with the rounding error made computing it
+template <typename T>
+struct compensated {
+  constexpr compensated(const T& sum_in, const T& error_in = T{0})
+      : sum(sum_in), error(error_in) {}
+
+  T sum;
+  T error;
+};
+
+// Adds two compensated sums, adding the rounding error of `a.sum + b.sum`
+// (Knuth's TwoSum, exact unless the addition overflows) to the errors
+struct compensated_add {
+  template <typename T>
+  constexpr compensated<T> operator()(const compensated<T>& a,
+                                      const compensated<T>& b) const {
+    const T sum = a.sum + b.sum;
+    const T b_virtual = sum - a.sum;
+    const T a_virtual = sum - b_virtual;
+    return {sum,
+            a.error + b.error + ((a.sum - a_virtual) + (b.sum - b_virtual))};
+  }
+};
+}  // namespace tuple_impl_detail
+
+/*!
+ * \brief Reduces the elements of `tuple` with `combine` in a balanced binary
+ * tree, returning `identity` for an empty tuple.
+ *
+ * Unlike a tuple_fold accumulating into a single state, the reductions of the
+ * two halves of the tuple are independent, so the critical path is only
+ * log2 of the tuple size long and the additions of a long tuple can overlap.
+ * For floating point sums the rounding error also grows with the log of the
+ * size instead of linearly. `combine` must be associative, since elements are
+ * combined in a different order than in a fold.
+ *
+ * \code
+ * const double sum = tuple_reduce(
+ *     tuple, [](const double a, const double b) { return a + b; }, 0.0);
+ * \endcode
+ */
+template <typename... Elements, typename Combine, typename T>
+constexpr T tuple_reduce(const std::tuple<Elements...>& tuple,
+                         Combine&& combine, const T& identity) {
+  return tuple_impl_detail::tuple_reduce_impl<0, sizeof...(Elements)>(
+      tuple, combine, identity,
+      tuple_impl_detail::reduce_size<sizeof...(Elements)>{});
+}
+
+/*!
+ * \brief Sums the elements of `tuple` with tuple_reduce, carrying the
+ * rounding error of every addition along and adding it at the end.
+ *
+ * The result is as accurate as summing in twice the precision of `T` and
+ * rounding once, at a few times the cost of tuple_reduce. Do not compile
+ * with `-ffast-math` or similar, which allows the compiler to optimize the
+ * rounding errors away.
+ */
+template <typename... Elements, typename T>
+constexpr T tuple_compensated_sum(const std::tuple<Elements...>& tuple,
+                                  const T& identity) {
+  const tuple_impl_detail::compensated<T> result =
+      tuple_reduce(tuple, tuple_impl_detail::compensated_add{},
+                   tuple_impl_detail::compensated<T>{identity});
+  return result.sum + result.error;
+}
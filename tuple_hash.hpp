@@ -0,0 +1,221 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "tuple_fold.hpp"
+
+namespace tuple_hash_detail {
+constexpr std::uint64_t seed = 0x243F6A8885A308D3ULL;
+constexpr std::uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+
+// The 64 bits hashed for one element. Trivially copyable elements of up to 8
+// bytes whose bytes determine their value (integers, enums, pointers) are
+// hashed as their raw bytes, and floating point numbers too after mapping -0.0
+// to 0.0 since the two compare equal. Everything else is hashed with
+// std::hash. Integers are zero-extended rather than copied into the word,
+// which gives the same bits but lets the bulk loops vectorize.
+template <class T>
+std::uint64_t hash_word(const T& value) {
+  if constexpr (std::is_integral_v<T> and not std::is_same_v<T, bool> and
+                sizeof(T) <= 8) {
+    using unsigned_type = std::make_unsigned_t<T>;
+    return static_cast<std::uint64_t>(static_cast<unsigned_type>(value));
+  } else if constexpr (std::is_floating_point_v<T> and sizeof(T) <= 8) {
+    const T normalized = value == T{0} ? T{0} : value;
+    std::uint64_t word = 0;
+    std::memcpy(&word, &normalized, sizeof(T));
+    return word;
+  } else if constexpr (std::is_trivially_copyable_v<T> and sizeof(T) <= 8 and
+                       std::has_unique_object_representations_v<T>) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, &value, sizeof(T));
+    return word;
+  } else {
+    return static_cast<std::uint64_t>(std::hash<T>{}(value));
+  }
+}
+
+// Only a xor, a multiply and a shift, so that hashing many rows at once
+// vectorizes
+inline std::uint64_t mix(std::uint64_t state, const std::uint64_t word) {
+  state = (state ^ word) * multiplier;
+  return state ^ (state >> 32);
+}
+
+// The finalizer of MurmurHash3, so that every bit of the state affects the
+// low bits used to pick hash table buckets
+inline std::uint64_t finalize(std::uint64_t state) {
+  state ^= state >> 33;
+  state *= 0xFF51AFD7ED558CCDULL;
+  state ^= state >> 33;
+  return state;
+}
+
+// Number of rows tuple_hash_bulk hashes column by column at a time, small
+// enough for the states to stay in L1
+constexpr size_t block_size = 256;
+
+template <class... Ts, size_t... Is>
+void hash_row_block(const std::tuple<Ts...>* const rows, const size_t count,
+                    std::uint64_t* const states,
+                    std::index_sequence<Is...> /*meta*/) {
+  static_cast<void>(std::initializer_list<char>{
+      (static_cast<void>([rows, count, states]() {
+         for (size_t row = 0; row < count; ++row) {
+           states[row] = mix(states[row], hash_word(std::get<Is>(rows[row])));
+         }
+       }()),
+       '0')...});
+}
+}  // namespace tuple_hash_detail
+
+/*!
+ * \brief Hashes a `std::tuple` by mixing one 64-bit word per element, using
+ * tuple_fold.
+ *
+ * Elements that are integers, enums, pointers or floating point numbers of up
+ * to 8 bytes are hashed as their bytes, other elements with `std::hash`. Use
+ * with tuple_equal as the hash and key equality of unordered containers:
+ *
+ * \code
+ * std::unordered_map<std::tuple<int, int, double>, size_t, tuple_hash,
+ *                    tuple_equal> map;
+ * \endcode
+ *
+ * \see tuple_equal tuple_hash_bulk tuple_hash_columns
+ */
+struct tuple_hash {
+  template <class... Ts>
+  size_t operator()(const std::tuple<Ts...>& tuple) const {
+    std::uint64_t state = tuple_hash_detail::seed;
+    tuple_fold(
+        tuple,
+        [](const auto& element, std::uint64_t& s) {
+          s = tuple_hash_detail::mix(s, tuple_hash_detail::hash_word(element));
+        },
+        state);
+    return static_cast<size_t>(tuple_hash_detail::finalize(state));
+  }
+};
+
+/*!
+ * \brief Compares two `std::tuple`s element by element, without branching
+ * between the elements.
+ *
+ * \see tuple_hash
+ */
+struct tuple_equal {
+  template <class... Ts>
+  bool operator()(const std::tuple<Ts...>& a,
+                  const std::tuple<Ts...>& b) const {
+    bool equal = true;
+    tuple_transform(
+        a,
+        [&b](const auto& element, auto index, bool& state) {
+          state &= element == std::get<decltype(index)::value>(b);
+        },
+        equal);
+    return equal;
+  }
+};
+
+/*!
+ * \brief Writes `tuple_hash{}(rows[i])` to `hashes[i]` for the `count` rows.
+ *
+ * The rows are hashed in blocks, one column (tuple element) of the block at a
+ * time, so that the mixing of the rows is independent and vectorizes.
+ *
+ * \see tuple_hash_columns
+ */
+template <class... Ts>
+void tuple_hash_bulk(const std::tuple<Ts...>* const rows, const size_t count,
+                     size_t* const hashes) {
+  std::uint64_t states[tuple_hash_detail::block_size];
+  for (size_t begin = 0; begin < count;
+       begin += tuple_hash_detail::block_size) {
+    const size_t size = count - begin < tuple_hash_detail::block_size
+                            ? count - begin
+                            : tuple_hash_detail::block_size;
+    for (size_t row = 0; row < size; ++row) {
+      states[row] = tuple_hash_detail::seed;
+    }
+    tuple_hash_detail::hash_row_block(rows + begin, size, states,
+                                      std::index_sequence_for<Ts...>{});
+    for (size_t row = 0; row < size; ++row) {
+      hashes[begin + row] =
+          static_cast<size_t>(tuple_hash_detail::finalize(states[row]));
+    }
+  }
+}
+
+/*!
+ * \brief Writes the tuple_hash of row `i` of the columns to `hashes[i]` for
+ * the `count` rows, where element `j` of row `i` is `std::get<j>(columns)[i]`.
+ *
+ * Since each column is contiguous the mixing loop over a column vectorizes
+ * fully. The result equals tuple_hash of the row as a
+ * `std::tuple<std::remove_const_t<Ts>...>`.
+ *
+ * \see tuple_hash_bulk
+ */
+template <class... Ts>
+void tuple_hash_columns(const std::tuple<Ts*...>& columns,
+                        const size_t count, size_t* const hashes) {
+  std::uint64_t states[tuple_hash_detail::block_size];
+  for (size_t begin = 0; begin < count;
+       begin += tuple_hash_detail::block_size) {
+    const size_t size = count - begin < tuple_hash_detail::block_size
+                            ? count - begin
+                            : tuple_hash_detail::block_size;
+    for (size_t row = 0; row < size; ++row) {
+      states[row] = tuple_hash_detail::seed;
+    }
+    tuple_transform(columns, [&states, begin, size](const auto& column,
+                                                    auto /*index*/) {
+      for (size_t row = 0; row < size; ++row) {
+        states[row] = tuple_hash_detail::mix(
+            states[row], tuple_hash_detail::hash_word(column[begin + row]));
+      }
+    });
+    for (size_t row = 0; row < size; ++row) {
+      hashes[begin + row] =
+          static_cast<size_t>(tuple_hash_detail::finalize(states[row]));
+    }
+  }
+}
@@ -0,0 +1,224 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compares hashing rows of type std::tuple<int, int, double, long> by
+ * combining std::hash of each element, with tuple_hash one row at a time,
+ * with tuple_hash_bulk on the rows, and with tuple_hash_columns on the same
+ * data stored as one array per element. Prints the time per row, and the
+ * time per probe of a std::unordered_map keyed on the rows with either hash.
+ *
+ * Compile the code using:
+ * clang++ -std=c++17 -O3 -march=native ./tuple_hash_benchmark.cpp
+ * g++ -std=c++17 -O3 -march=native ./tuple_hash_benchmark.cpp
+ */
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "tuple_hash.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define NEVER_INLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NEVER_INLINE __declspec(noinline)
+#else
+#define NEVER_INLINE
+#endif
+
+namespace {
+using row = std::tuple<int, int, double, long>;
+
+// The usual boost::hash_combine of std::hash of each element
+struct naive_hash {
+  size_t operator()(const row& r) const {
+    size_t seed = 0;
+    const auto combine = [&seed](const size_t hash) {
+      seed ^= hash + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    };
+    combine(std::hash<int>{}(std::get<0>(r)));
+    combine(std::hash<int>{}(std::get<1>(r)));
+    combine(std::hash<double>{}(std::get<2>(r)));
+    combine(std::hash<long>{}(std::get<3>(r)));
+    return seed;
+  }
+};
+
+struct columns {
+  std::vector<int> a;
+  std::vector<int> b;
+  std::vector<double> c;
+  std::vector<long> d;
+};
+
+void tuple_hash_example() {
+  const tuple_hash hash{};
+  const tuple_equal equal{};
+  assert(hash(row{1, 2, 3.0, 4}) == hash(row{1, 2, 3.0, 4}));
+  assert(hash(row{1, 2, 3.0, 4}) != hash(row{2, 1, 3.0, 4}));
+  // -0.0 == 0.0, so the two must hash the same
+  assert(equal(row{1, 2, -0.0, 4}, row{1, 2, 0.0, 4}));
+  assert(hash(row{1, 2, -0.0, 4}) == hash(row{1, 2, 0.0, 4}));
+  assert(not equal(row{1, 2, 3.0, 4}, row{1, 2, 3.0, 5}));
+  // Elements that are not hashed as bytes fall back to std::hash
+  assert(hash(std::make_tuple(std::string{"key"}, 1)) ==
+         hash(std::make_tuple(std::string{"key"}, 1)));
+  assert(equal(std::make_tuple(std::string{"key"}, 1),
+               std::make_tuple(std::string{"key"}, 1)));
+
+  std::unordered_map<row, int, tuple_hash, tuple_equal> map;
+  map[row{1, 2, 3.0, 4}] = 5;
+  map[row{1, 2, 0.0, 4}] = 6;
+  assert(map.at(row{1, 2, 3.0, 4}) == 5);
+  assert(map.at(row{1, 2, -0.0, 4}) == 6);
+
+  // The bulk paths agree with hashing one row at a time, also for counts that
+  // are not a multiple of the block size
+  std::vector<row> rows;
+  columns cols;
+  for (int i = 0; i < 1000; ++i) {
+    rows.emplace_back(i, -i, 0.5 * i, 3L * i);
+    cols.a.push_back(i);
+    cols.b.push_back(-i);
+    cols.c.push_back(0.5 * i);
+    cols.d.push_back(3L * i);
+  }
+  std::vector<size_t> bulk(rows.size());
+  std::vector<size_t> columnar(rows.size());
+  tuple_hash_bulk(rows.data(), rows.size(), bulk.data());
+  tuple_hash_columns(std::make_tuple(cols.a.data(), cols.b.data(),
+                                     cols.c.data(), cols.d.data()),
+                     rows.size(), columnar.data());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    assert(bulk[i] == hash(rows[i]));
+    assert(columnar[i] == hash(rows[i]));
+  }
+}
+
+template <class Hash>
+NEVER_INLINE void hash_rows(const std::vector<row>& rows,
+                            std::vector<size_t>& hashes) {
+  const Hash hash{};
+  for (size_t i = 0; i < rows.size(); ++i) {
+    hashes[i] = hash(rows[i]);
+  }
+}
+
+NEVER_INLINE void hash_bulk(const std::vector<row>& rows,
+                            std::vector<size_t>& hashes) {
+  tuple_hash_bulk(rows.data(), rows.size(), hashes.data());
+}
+
+NEVER_INLINE void hash_columns(const columns& cols,
+                               std::vector<size_t>& hashes) {
+  tuple_hash_columns(std::make_tuple(cols.a.data(), cols.b.data(),
+                                     cols.c.data(), cols.d.data()),
+                     hashes.size(), hashes.data());
+}
+
+template <class F>
+double ns_per_call(F&& f) {
+  size_t repetitions = 1;
+  while (true) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < repetitions; ++r) {
+      f();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double elapsed_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    if (elapsed_ns > 5.0e7) {
+      return elapsed_ns / static_cast<double>(repetitions);
+    }
+    repetitions *= 2;
+  }
+}
+
+template <class Hash, class Equal>
+double ns_per_probe(const std::vector<row>& rows) {
+  std::unordered_map<row, size_t, Hash, Equal> map;
+  for (size_t i = 0; i < rows.size() / 2; ++i) {
+    map.emplace(rows[i], i);
+  }
+  volatile size_t found = 0;
+  return ns_per_call([&map, &rows, &found]() {
+           size_t count = 0;
+           for (const auto& r : rows) {
+             count += map.count(r);
+           }
+           found = count;
+         }) /
+         static_cast<double>(rows.size());
+}
+}  // namespace
+
+int main() {
+  tuple_hash_example();
+
+  const size_t count = 1 << 16;
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<int> small(0, 1000);
+  std::uniform_real_distribution<double> real(0.0, 1.0);
+  std::vector<row> rows(count);
+  columns cols;
+  for (auto& r : rows) {
+    r = row{small(generator), small(generator), real(generator),
+            static_cast<long>(generator())};
+    cols.a.push_back(std::get<0>(r));
+    cols.b.push_back(std::get<1>(r));
+    cols.c.push_back(std::get<2>(r));
+    cols.d.push_back(std::get<3>(r));
+  }
+  std::vector<size_t> hashes(count);
+  const double rows_d = static_cast<double>(count);
+
+  std::printf("%-34s %10s\n", "method", "ns/row");
+  std::printf("%-34s %10.3f\n", "std::hash combining",
+              ns_per_call([&]() { hash_rows<naive_hash>(rows, hashes); }) /
+                  rows_d);
+  std::printf("%-34s %10.3f\n", "tuple_hash",
+              ns_per_call([&]() { hash_rows<tuple_hash>(rows, hashes); }) /
+                  rows_d);
+  std::printf("%-34s %10.3f\n", "tuple_hash_bulk",
+              ns_per_call([&]() { hash_bulk(rows, hashes); }) / rows_d);
+  std::printf("%-34s %10.3f\n", "tuple_hash_columns",
+              ns_per_call([&]() { hash_columns(cols, hashes); }) / rows_d);
+  std::printf("%-34s %10.3f\n", "unordered_map probe, std::hash",
+              ns_per_probe<naive_hash, std::equal_to<row>>(rows));
+  std::printf("%-34s %10.3f\n", "unordered_map probe, tuple_hash",
+              ns_per_probe<tuple_hash, tuple_equal>(rows));
+}
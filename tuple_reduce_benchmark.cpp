@@ -0,0 +1,265 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Compares summing the elements of tuples of 8 to 128 doubles with a
+ * sequential tuple_fold, with the pairwise tuple_reduce, and with
+ * tuple_compensated_sum. Prints the time per element both when the sums are
+ * independent of each other (throughput) and when each sum depends on the
+ * previous one (latency), and the mean relative error of each method for
+ * well-conditioned and ill-conditioned data.
+ *
+ * Compile the code using:
+ * clang++ -std=c++14 -O3 ./tuple_reduce_benchmark.cpp
+ * g++ -std=c++14 -O3 ./tuple_reduce_benchmark.cpp
+ */
+
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <initializer_list>
+#include <random>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tuple_fold.hpp"
+
+#if defined(__clang__) || defined(__GNUC__) || defined(__GNUG__)
+#define NEVER_INLINE __attribute__((noinline))
+#elif defined(_MSC_VER)
+#define NEVER_INLINE __declspec(noinline)
+#else
+#define NEVER_INLINE
+#endif
+
+namespace {
+template <size_t I>
+using double_at = double;
+
+template <size_t... Is>
+std::tuple<double_at<Is>...> make_double_tuple(
+    std::index_sequence<Is...> /*meta*/);
+
+template <size_t Size>
+using double_tuple =
+    decltype(make_double_tuple(std::make_index_sequence<Size>{}));
+
+struct plus {
+  constexpr double operator()(const double a, const double b) const {
+    return a + b;
+  }
+};
+
+struct fold_sum {
+  static constexpr const char* name = "tuple_fold";
+  template <class Tuple>
+  static double apply(const Tuple& tuple) {
+    double sum = 0.0;
+    tuple_fold(
+        tuple, [](const double element, double& state) { state += element; },
+        sum);
+    return sum;
+  }
+};
+
+struct reduce_sum {
+  static constexpr const char* name = "tuple_reduce";
+  template <class Tuple>
+  static double apply(const Tuple& tuple) {
+    return tuple_reduce(tuple, plus{}, 0.0);
+  }
+};
+
+struct compensated_sum {
+  static constexpr const char* name = "tuple_compensated_sum";
+  template <class Tuple>
+  static double apply(const Tuple& tuple) {
+    return tuple_compensated_sum(tuple, 0.0);
+  }
+};
+
+void tuple_reduce_example() {
+  static_assert(tuple_reduce(std::make_tuple(1, 2, 3, 4, 5), plus{}, 0.0) ==
+                    15.0,
+                "");
+  static_assert(tuple_reduce(std::tuple<>{}, plus{}, 1.5) == 1.5, "");
+  static_assert(tuple_compensated_sum(std::make_tuple(1.0, 2, 3.0f), 0.0) ==
+                    6.0,
+                "");
+
+  // The tree for 5 elements is ((0 1) (2 (3 4)))
+  const auto order = tuple_reduce(
+      std::make_tuple("a", "b", "c", "d", "e"),
+      [](const std::string& a, const std::string& b) {
+        return "(" + a + " " + b + ")";
+      },
+      std::string{});
+  assert(order == "((a b) (c (d e)))");
+
+  // 1 + 1e-16 + ... rounds to 1 in every addition of a sequential sum
+  const auto tuple = std::make_tuple(1.0, 1.0e-16, 1.0e-16, 1.0e-16, 1.0e-16,
+                                     1.0e-16, 1.0e-16, 1.0e-16);
+  assert(fold_sum::apply(tuple) == 1.0);
+  assert(tuple_compensated_sum(tuple, 0.0) == 1.0 + 7.0e-16);
+}
+
+template <class Method, size_t Size>
+NEVER_INLINE double sum_independent(
+    const std::vector<double_tuple<Size>>& data) {
+  double total = 0.0;
+  for (const auto& tuple : data) {
+    total += Method::apply(tuple);
+  }
+  return total;
+}
+
+// Feeds each sum into the first element of the next tuple, so that the next
+// sum cannot start before the previous one is done
+template <class Method, size_t Size>
+NEVER_INLINE double sum_dependent(
+    const std::vector<double_tuple<Size>>& data) {
+  double carry = 0.0;
+  for (const auto& tuple : data) {
+    auto copy = tuple;
+    std::get<0>(copy) += carry * 1.0e-300;
+    carry = Method::apply(copy);
+  }
+  return carry;
+}
+
+template <class Tuple, class F, size_t... Is>
+void fill(Tuple& tuple, F&& f, std::index_sequence<Is...> /*meta*/) {
+  static_cast<void>(std::initializer_list<char>{
+      (static_cast<void>(std::get<Is>(tuple) = f()), '0')...});
+}
+
+template <size_t Size>
+std::vector<double_tuple<Size>> make_data(const size_t count,
+                                          const bool ill_conditioned,
+                                          std::mt19937& generator) {
+  std::uniform_real_distribution<double> value(0.0, 1.0);
+  std::uniform_int_distribution<int> exponent(-20, 20);
+  std::vector<double_tuple<Size>> data(count);
+  for (auto& tuple : data) {
+    fill(tuple,
+         [&]() {
+           return ill_conditioned ? std::ldexp(value(generator) - 0.5,
+                                               exponent(generator))
+                                  : value(generator);
+         },
+         std::make_index_sequence<Size>{});
+  }
+  return data;
+}
+
+template <class F>
+double ns_per_call(F&& f) {
+  size_t repetitions = 1;
+  while (true) {
+    const auto start = std::chrono::steady_clock::now();
+    volatile double sink = 0.0;
+    for (size_t r = 0; r < repetitions; ++r) {
+      sink = sink + f();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double elapsed_ns =
+        std::chrono::duration<double, std::nano>(stop - start).count();
+    if (elapsed_ns > 5.0e7) {
+      return elapsed_ns / static_cast<double>(repetitions);
+    }
+    repetitions *= 2;
+  }
+}
+
+template <class Method, size_t Size>
+void benchmark(const std::vector<double_tuple<Size>>& data,
+               const std::vector<double_tuple<Size>>& well_conditioned,
+               const std::vector<double_tuple<Size>>& ill_conditioned) {
+  const double elements = static_cast<double>(data.size() * Size);
+  const double throughput =
+      ns_per_call([&data]() { return sum_independent<Method, Size>(data); }) /
+      elements;
+  const double latency =
+      ns_per_call([&data]() { return sum_dependent<Method, Size>(data); }) /
+      elements;
+
+  // The relative error against a sequential sum in long double, which is at
+  // least as precise as double
+  const auto relative_error =
+      [](const std::vector<double_tuple<Size>>& tuples) {
+        double error = 0.0;
+        for (const auto& tuple : tuples) {
+          long double exact = 0.0L;
+          tuple_fold(
+              tuple,
+              [](const double element, long double& state) {
+                state += element;
+              },
+              exact);
+          if (exact != 0.0L) {
+            error += static_cast<double>(
+                std::abs((Method::apply(tuple) - exact) / exact));
+          }
+        }
+        return error / static_cast<double>(tuples.size());
+      };
+  std::printf("%4zu %-22s | %10.3f %10.3f | %12.3e %12.3e\n", Size,
+              Method::name, throughput, latency,
+              relative_error(well_conditioned),
+              relative_error(ill_conditioned));
+}
+
+template <size_t Size>
+void benchmark_size(std::mt19937& generator) {
+  const size_t count = 16384 / Size;
+  const auto data = make_data<Size>(count, false, generator);
+  const auto well_conditioned = make_data<Size>(1000, false, generator);
+  const auto ill_conditioned = make_data<Size>(1000, true, generator);
+  benchmark<fold_sum, Size>(data, well_conditioned, ill_conditioned);
+  benchmark<reduce_sum, Size>(data, well_conditioned, ill_conditioned);
+  benchmark<compensated_sum, Size>(data, well_conditioned, ill_conditioned);
+}
+}  // namespace
+
+int main() {
+  tuple_reduce_example();
+
+  std::mt19937 generator(42);
+  std::printf("%4s %-22s | %10s %10s | %12s %12s\n", "size", "method",
+              "throughput", "latency", "error", "error");
+  std::printf("%4s %-22s | %10s %10s | %12s %12s\n", "", "", "ns/element",
+              "ns/element", "well-cond.", "ill-cond.");
+  benchmark_size<8>(generator);
+  benchmark_size<32>(generator);
+  benchmark_size<128>(generator);
+}
@@ -0,0 +1,226 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "typelist.hpp"
+
+namespace typed_mpsc_queue_detail {
+template <class T, class... Ts>
+struct index_of;
+
+template <class T, class... Ts>
+struct index_of<T, T, Ts...> : std::integral_constant<size_t, 0> {};
+
+template <class T, class U, class... Ts>
+struct index_of<T, U, Ts...>
+    : std::integral_constant<size_t, 1 + index_of<T, Ts...>::value> {};
+
+template <class T>
+struct index_of<T> {
+  static_assert(not std::is_same_v<T, T>,
+                "The type is not one of the messages of the queue");
+};
+
+// Keeps the counters written by the producers and by the consumer on
+// separate cache lines
+constexpr size_t cache_line = 64;
+}  // namespace typed_mpsc_queue_detail
+
+template <class MessageList, size_t Capacity>
+class typed_mpsc_queue;
+
+/*!
+ * \brief A bounded, lock-free queue from any number of producer threads to one
+ * consumer thread of messages of the types `Msgs...`.
+ *
+ * Each message is stored inline in a ring of `Capacity` slots, together with
+ * the index of its type. The ring is allocated once by the constructor, and
+ * pushing and draining never allocate. This is
+ * the bounded queue of D. Vyukov: every slot has a sequence number that tells
+ * a producer whether the slot is free for the lap of the ring it claimed, and
+ * the consumer whether the message in it has been written. Producers claim a
+ * slot with one compare-and-swap of the tail, and the consumer, being the only
+ * one, needs no read-modify-write at all.
+ *
+ * The consumer drains messages in batches by calling a visitor on each of
+ * them, typically an overloader with one lambda per message type. The visitor
+ * is called with an rvalue of the message, which is destroyed afterwards.
+ * Messages of the same producer are drained in the order they were pushed.
+ *
+ * \example
+ * \code
+ * typed_mpsc_queue<typelist<order, cancel>, 1024> queue{};
+ * // On any producer thread
+ * queue.push(order{id, price});
+ * // On the consumer thread
+ * queue.drain(make_overloader([&book](const order& o) { book.add(o); },
+ *                             [&book](const cancel& c) { book.erase(c); }));
+ * \endcode
+ *
+ * \note The messages must be nothrow move constructible, since a slot that
+ * was claimed must be filled, and the visitor must not throw.
+ */
+template <class... Msgs, size_t Capacity>
+class typed_mpsc_queue<typelist<Msgs...>, Capacity> {
+  static_assert(sizeof...(Msgs) > 0, "A queue needs at least one message type");
+  static_assert(sizeof...(Msgs) <= 256,
+                "The index of the message type is stored in one byte");
+  static_assert(Capacity >= 2 and (Capacity & (Capacity - 1)) == 0,
+                "The capacity must be a power of two");
+  static_assert((std::is_nothrow_move_constructible_v<Msgs> and ...),
+                "The messages must be nothrow move constructible");
+
+  struct slot {
+    std::atomic<size_t> sequence;
+    std::uint8_t type;
+    alignas(Msgs...) unsigned char storage[std::max({sizeof(Msgs)...})];
+  };
+
+ public:
+  static constexpr size_t capacity = Capacity;
+
+  typed_mpsc_queue() : slots_(new slot[Capacity]) {
+    for (size_t i = 0; i < Capacity; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  typed_mpsc_queue(const typed_mpsc_queue&) = delete;
+  typed_mpsc_queue& operator=(const typed_mpsc_queue&) = delete;
+
+  /// Destroys the messages that were not drained
+  ~typed_mpsc_queue() {
+    drain([](auto&& /*message*/) {});
+  }
+
+  /*!
+   * \brief Adds `message` if the queue is not full, and returns whether it
+   * did. Can be called from any number of threads at once.
+   */
+  template <class T>
+  bool try_push(T&& message) {
+    using message_type = std::decay_t<T>;
+    constexpr auto type = static_cast<std::uint8_t>(
+        typed_mpsc_queue_detail::index_of<message_type, Msgs...>::value);
+    size_t position = tail_.load(std::memory_order_relaxed);
+    slot* s = nullptr;
+    while (true) {
+      s = &slots_[position & (Capacity - 1)];
+      const size_t sequence = s->sequence.load(std::memory_order_acquire);
+      const auto lap = static_cast<std::ptrdiff_t>(sequence - position);
+      if (lap == 0) {
+        // The slot is free for this lap: claim it
+        if (tail_.compare_exchange_weak(position, position + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (lap < 0) {
+        // The consumer has not drained the message of the previous lap
+        return false;
+      } else {
+        // Another producer claimed the slot first
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    ::new (static_cast<void*>(s->storage))
+        message_type(std::forward<T>(message));
+    s->type = type;
+    s->sequence.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Adds `message`, yielding the thread while the queue is full
+  template <class T>
+  void push(T&& message) {
+    while (not try_push(std::forward<T>(message))) {
+      std::this_thread::yield();
+    }
+  }
+
+  /*!
+   * \brief Calls `visitor` on at most `max_messages` of the messages in the
+   * queue, in order, and returns how many it called it on. Must only be
+   * called from the consumer thread.
+   *
+   * The slots are handed back to the producers as they are visited, but the
+   * head of the queue is only written once per batch.
+   */
+  template <class Visitor>
+  size_t drain(Visitor&& visitor, const size_t max_messages = Capacity) {
+    size_t position = head_;
+    size_t drained = 0;
+    for (; drained < max_messages; ++drained, ++position) {
+      slot& s = slots_[position & (Capacity - 1)];
+      if (s.sequence.load(std::memory_order_acquire) != position + 1) {
+        break;
+      }
+      visit(s, visitor, std::index_sequence_for<Msgs...>{});
+      s.sequence.store(position + Capacity, std::memory_order_release);
+    }
+    head_ = position;
+    return drained;
+  }
+
+  /// Whether the queue was empty, as seen from the consumer thread
+  bool empty() const {
+    return slots_[head_ & (Capacity - 1)].sequence.load(
+               std::memory_order_acquire) != head_ + 1;
+  }
+
+ private:
+  template <class Visitor, size_t... Is>
+  static void visit(slot& s, Visitor& visitor,
+                    std::index_sequence<Is...> /*meta*/) {
+    // Compiles to a chain of compares or a jump table on the type index
+    static_cast<void>(
+        ((s.type == Is ? (call<Msgs>(s, visitor), true) : false) or ...));
+  }
+
+  template <class T, class Visitor>
+  static void call(slot& s, Visitor& visitor) {
+    T* const message = std::launder(reinterpret_cast<T*>(s.storage));
+    visitor(std::move(*message));
+    message->~T();
+  }
+
+  const std::unique_ptr<slot[]> slots_;
+  alignas(typed_mpsc_queue_detail::cache_line) std::atomic<size_t> tail_{0};
+  alignas(typed_mpsc_queue_detail::cache_line) size_t head_{0};
+};
@@ -0,0 +1,306 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+/*
+ * Sends three kinds of events from 1 to 32 producer threads to one consumer,
+ * once through typed_mpsc_queue drained with an overloader, and once through
+ * a mutex-protected std::queue<std::function<void()>> that the consumer
+ * swaps out to run a whole batch at a time. Prints the messages per second
+ * and the 50th, 99th and 99.9th percentiles of the time from push to
+ * handling. Also checks that every message arrives exactly once, in order per
+ * producer, and that the typed queue does not allocate per message.
+ *
+ * Compile the code using:
+ * clang++ -std=c++17 -O3 -pthread ./typed_mpsc_queue_benchmark.cpp
+ * g++ -std=c++17 -O3 -pthread ./typed_mpsc_queue_benchmark.cpp
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "overloader.hpp"
+#include "typed_mpsc_queue.hpp"
+
+namespace {
+std::atomic<size_t> allocations{0};
+}  // namespace
+
+// Counts the allocations of the whole program
+void* operator new(const size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* const p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* const p) noexcept { std::free(p); }
+
+void operator delete(void* const p, const size_t /*size*/) noexcept {
+  std::free(p);
+}
+
+namespace {
+std::int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct header {
+  std::int64_t sent_ns;
+  std::uint32_t producer;
+  std::uint32_t sequence;
+};
+
+struct order {
+  header head;
+  double price;
+  std::uint32_t quantity;
+};
+
+struct cancel {
+  header head;
+  std::uint64_t order_id;
+};
+
+struct heartbeat {
+  header head;
+};
+
+using event_queue = typed_mpsc_queue<typelist<order, cancel, heartbeat>, 4096>;
+
+struct consumer_state {
+  explicit consumer_state(const size_t producers, const size_t total)
+      : next_sequence(producers, 0) {
+    latencies_ns.reserve(total);
+  }
+
+  void record(const header& head) {
+    assert(head.sequence == next_sequence[head.producer]);
+    ++next_sequence[head.producer];
+    latencies_ns.push_back(now_ns() - head.sent_ns);
+    ++received;
+  }
+
+  std::vector<std::uint32_t> next_sequence;
+  std::vector<std::int64_t> latencies_ns;
+  size_t received = 0;
+  double volume = 0.0;
+  std::uint64_t cancelled = 0;
+};
+
+// Producer `p` sends orders, cancels and heartbeats in turn
+template <class Send>
+void produce(const std::uint32_t producer, const std::uint32_t count,
+             const std::atomic<bool>& go, Send&& send) {
+  while (not go.load(std::memory_order_acquire)) {
+    std::this_thread::yield();
+  }
+  for (std::uint32_t i = 0; i < count; ++i) {
+    const header head{now_ns(), producer, i};
+    switch (i % 3) {
+      case 0:
+        send(order{head, 100.0 + i % 7, i % 13 + 1});
+        break;
+      case 1:
+        send(cancel{head, i - 1});
+        break;
+      default:
+        send(heartbeat{head});
+        break;
+    }
+  }
+}
+
+struct result {
+  double messages_per_second;
+  double p50_us;
+  double p99_us;
+  double p999_us;
+};
+
+result summarize(consumer_state& state, const double seconds) {
+  auto& latencies = state.latencies_ns;
+  std::sort(latencies.begin(), latencies.end());
+  const auto percentile = [&latencies](const double p) {
+    return static_cast<double>(
+               latencies[static_cast<size_t>(
+                   p * static_cast<double>(latencies.size() - 1))]) /
+           1.0e3;
+  };
+  return {static_cast<double>(latencies.size()) / seconds, percentile(0.5),
+          percentile(0.99), percentile(0.999)};
+}
+
+result run_typed(const size_t producers, const std::uint32_t per_producer) {
+  event_queue queue{};
+  consumer_state state{producers, producers * per_producer};
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  for (size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&queue, &go, p, per_producer]() {
+      produce(static_cast<std::uint32_t>(p), per_producer, go,
+              [&queue](auto message) { queue.push(message); });
+    });
+  }
+  const auto visitor = make_overloader(
+      [&state](const order& o) {
+        state.volume += o.price * o.quantity;
+        state.record(o.head);
+      },
+      [&state](const cancel& c) {
+        state.cancelled += c.order_id;
+        state.record(c.head);
+      },
+      [&state](const heartbeat& h) { state.record(h.head); });
+
+  const size_t total = producers * per_producer;
+  const auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  while (state.received < total) {
+    if (queue.drain(visitor) == 0) {
+      std::this_thread::yield();
+    }
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  assert(queue.empty());
+  return summarize(state,
+                   std::chrono::duration<double>(stop - start).count());
+}
+
+result run_mutex(const size_t producers, const std::uint32_t per_producer) {
+  std::mutex mutex;
+  std::queue<std::function<void()>> queue;
+  consumer_state state{producers, producers * per_producer};
+  std::atomic<bool> go{false};
+  std::vector<std::thread> threads;
+  const auto handle = make_overloader(
+      [&state](const order& o) {
+        state.volume += o.price * o.quantity;
+        state.record(o.head);
+      },
+      [&state](const cancel& c) {
+        state.cancelled += c.order_id;
+        state.record(c.head);
+      },
+      [&state](const heartbeat& h) { state.record(h.head); });
+  for (size_t p = 0; p < producers; ++p) {
+    threads.emplace_back([&mutex, &queue, &go, &handle, p, per_producer]() {
+      produce(static_cast<std::uint32_t>(p), per_producer, go,
+              [&mutex, &queue, &handle](auto message) {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push([&handle, message]() { handle(message); });
+              });
+    });
+  }
+
+  const size_t total = producers * per_producer;
+  const auto start = std::chrono::steady_clock::now();
+  go.store(true, std::memory_order_release);
+  std::queue<std::function<void()>> batch;
+  while (state.received < total) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::swap(batch, queue);
+    }
+    if (batch.empty()) {
+      std::this_thread::yield();
+    }
+    for (; not batch.empty(); batch.pop()) {
+      batch.front()();
+    }
+  }
+  const auto stop = std::chrono::steady_clock::now();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return summarize(state,
+                   std::chrono::duration<double>(stop - start).count());
+}
+
+void check_no_allocations() {
+  event_queue queue{};
+  consumer_state state{1, 3 * event_queue::capacity};
+  const auto visitor = make_overloader(
+      [&state](const order& o) { state.record(o.head); },
+      [&state](const cancel& c) { state.record(c.head); },
+      [&state](const heartbeat& h) { state.record(h.head); });
+  const size_t before = allocations.load();
+  std::uint32_t sequence = 0;
+  for (size_t round = 0; round < 3; ++round) {
+    for (size_t i = 0; i < event_queue::capacity; ++i, ++sequence) {
+      const bool pushed = queue.try_push(heartbeat{{now_ns(), 0, sequence}});
+      assert(pushed);
+      static_cast<void>(pushed);
+    }
+    // Full: the next push fails until the consumer drains
+    assert(not queue.try_push(cancel{{now_ns(), 0, sequence}, 0}));
+    assert(queue.drain(visitor, 10) == 10);
+    assert(queue.drain(visitor) == event_queue::capacity - 10);
+    assert(queue.empty());
+  }
+  assert(allocations.load() == before);
+  assert(state.received == 3 * event_queue::capacity);
+}
+}  // namespace
+
+int main() {
+  check_no_allocations();
+
+  const std::uint32_t total = 1 << 20;
+  std::printf("%-9s %-14s %12s %10s %10s %10s\n", "producers", "queue",
+              "msgs/s", "p50 us", "p99 us", "p99.9 us");
+  for (const size_t producers : {1, 2, 4, 8, 16, 32}) {
+    const auto per_producer =
+        static_cast<std::uint32_t>(total / producers);
+    const auto print = [producers](const char* name, const result& r) {
+      std::printf("%-9zu %-14s %12.3g %10.2f %10.2f %10.2f\n", producers,
+                  name, r.messages_per_second, r.p50_us, r.p99_us,
+                  r.p999_us);
+    };
+    print("mutex+function", run_mutex(producers, per_producer));
+    print("typed_mpsc", run_typed(producers, per_producer));
+  }
+}
@@ -0,0 +1,211 @@
+/*
+Copyright 2017 Nils Deppe
+Distributed under the Boost Software License.
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+ * \brief A pool of worker threads, each with its own queue of jobs, that take
+ * jobs from the back of their own queue and steal from the front of the
+ * others' when it is empty.
+ *
+ * run() spreads a batch of jobs over the queues and then helps executing
+ * them on the calling thread until the whole batch is done, so a pool with
+ * no workers runs everything serially on the caller. A job is a function
+ * pointer and an argument, so queueing one does not allocate once the queues
+ * have grown. The queues are protected by a mutex each, which is cheap next
+ * to the coarse jobs the pool is meant for, such as the steps of a
+ * task_graph.
+ *
+ * The first exception thrown by a job of a batch is rethrown by run() after
+ * all the jobs of the batch have finished.
+ */
+class work_stealing_pool {
+ public:
+  struct job {
+    void (*function)(void*);
+    void* argument;
+  };
+
+  /// Starts `workers` threads in addition to the ones calling run()
+  explicit work_stealing_pool(
+      const size_t workers =
+          std::max(std::thread::hardware_concurrency(), 1u) - 1)
+      : queues_(workers + 1) {
+    for (auto& queue : queues_) {
+      queue = std::make_unique<job_queue>();
+    }
+    threads_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+      threads_.emplace_back([this, i]() { work(i); });
+    }
+  }
+
+  work_stealing_pool(const work_stealing_pool&) = delete;
+  work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+  ~work_stealing_pool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  size_t workers() const { return threads_.size(); }
+
+  /// Runs the `count` jobs and returns when all of them have finished
+  void run(const job* const jobs, const size_t count) {
+    if (count == 0) {
+      return;
+    }
+    batch current{};
+    current.pending = count;
+    // The caller takes from the last queue, so it starts with its share
+    for (size_t i = 0; i < count; ++i) {
+      job_queue& queue = *queues_[(queues_.size() - 1 + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.jobs.push_back({jobs[i], &current});
+    }
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      available_ += static_cast<std::ptrdiff_t>(count);
+    }
+    wake_.notify_all();
+
+    queued_job next{};
+    while (take(queues_.size() - 1, next)) {
+      execute(next);
+    }
+    // What is left is running on the workers
+    std::unique_lock<std::mutex> lock(current.mutex);
+    current.done.wait(lock, [&current]() { return current.pending == 0; });
+    if (current.error) {
+      std::rethrow_exception(current.error);
+    }
+  }
+
+ private:
+  struct batch {
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t pending = 0;
+    std::exception_ptr error;
+  };
+
+  struct queued_job {
+    job work;
+    batch* owner;
+  };
+
+  struct job_queue {
+    std::mutex mutex;
+    std::deque<queued_job> jobs;
+  };
+
+  // Pops the newest job of queue `self`, or else steals the oldest job of
+  // another queue
+  bool take(const size_t self, queued_job& result) {
+    for (size_t i = 0; i < queues_.size(); ++i) {
+      job_queue& queue = *queues_[(self + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.jobs.empty()) {
+        continue;
+      }
+      if (i == 0) {
+        result = queue.jobs.back();
+        queue.jobs.pop_back();
+      } else {
+        result = queue.jobs.front();
+        queue.jobs.pop_front();
+      }
+      available_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  static void execute(const queued_job& next) {
+    batch& owner = *next.owner;
+    std::exception_ptr error;
+    try {
+      next.work.function(next.work.argument);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    // The batch lives on the stack of run(), which may return as soon as
+    // pending is zero, so it is only touched under its mutex
+    std::lock_guard<std::mutex> lock(owner.mutex);
+    if (error and not owner.error) {
+      owner.error = error;
+    }
+    if (--owner.pending == 0) {
+      owner.done.notify_all();
+    }
+  }
+
+  void work(const size_t self) {
+    queued_job next{};
+    while (true) {
+      if (take(self, next)) {
+        execute(next);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wake_.wait(lock, [this]() {
+        return stop_ or available_.load(std::memory_order_relaxed) > 0;
+      });
+      if (stop_ and available_.load(std::memory_order_relaxed) <= 0) {
+        return;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<job_queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  // Jobs queued but not yet taken. It is added to after the jobs are queued,
+  // so it can briefly be negative
+  std::atomic<std::ptrdiff_t> available_{0};
+  bool stop_ = false;
+};